@@ -83,8 +83,18 @@ REVISIONS:
 2017-07-31: 1.0.1: AB: minor documenation update
 */
 
+#ifdef BENCH
+#define _GNU_SOURCE // sched_setaffinity()
+#endif
+
+#include <stddef.h>
 #include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
 #include <assert.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/uio.h>
 
 #ifdef __GNUC__
 #define GCC_ATTRIB(...) __attribute__((__VA_ARGS__))
@@ -150,6 +160,26 @@ INLINE uint16_t rotl16(uint16_t x, int k)
   return (x << k) | (x >> (16 - k));
 }
 
+// Native byte order loads with no alignment requirement. memcpy() avoids the
+// strict aliasing and alignment UB of casting a byte buffer to a word pointer,
+// and the compilers turn it into a single (unaligned) load.
+
+GCC_ATTRIB(nothrow,nonnull,pure)
+INLINE uint16_t load16(const uint8_t * p)
+{
+  uint16_t w;
+  memcpy(&w, p, sizeof(w));
+  return w;
+}
+
+GCC_ATTRIB(nothrow,nonnull,pure)
+INLINE uint32_t load32(const uint8_t * p)
+{
+  uint32_t w;
+  memcpy(&w, p, sizeof(w));
+  return w;
+}
+
 // uint64_t s[2]; // AYBern: Originally the author S.V. used this global var
 
 GCC_ATTRIB(nothrow,nonnull,flatten)
@@ -172,6 +202,37 @@ INLINE uint64_t Xoroshiro128Plus_next(uint64_t * s)
   return result;
 }
 
+// AYBern: Vigna's xoroshiro128+ jump() with the jump polynomial passed in, so
+// that we can jump by other distances than his 2^64. Applying jump[] to s is
+// equivalent to the number of Xoroshiro128Plus_next() calls that jump[]
+// encodes. XOROSHIRO128_JUMP_2_16 is 2^16 calls, which is one whole
+// AYBern_adlerHashCipherXorshift128_64() block: 2^17 words, 2 per draw. It is
+// x^(2^16) mod the characteristic polynomial of the generator, computed the
+// same way as his 2^64 jump, { 0xbeac0467eba5facb, 0xd86b048b86aa9922 },
+// which our derivation reproduces.
+
+#define XOROSHIRO128_JUMP_2_16 { UINT64_C(0x1e7aadfc624d3a05), UINT64_C(0x2dcb073daf1ce660) }
+
+GCC_ATTRIB(nothrow,nonnull)
+static void Xoroshiro128Plus_jump(uint64_t * s, const uint64_t jump[2])
+{
+  uint64_t s0 = 0;
+  uint64_t s1 = 0;
+
+  for (int i = 0; i < 2; ++i) {
+    for (int b = 0; b < 64; ++b) {
+      if (jump[i] & (UINT64_C(1) << b)) {
+        s0 ^= s[0];
+        s1 ^= s[1];
+      }
+      Xoroshiro128Plus_next(s);
+    }
+  }
+
+  s[0] = s0;
+  s[1] = s1;
+}
+
 /*
   The SplitMix_next() function that immediately follows was written in 2015 by
   Sebastiano Vigna (vigna@acm.org).
@@ -204,6 +265,171 @@ static uint64_t SplitMix_next(uint64_t x)
   return z ^ (z >> 31);
 }
 
+/*
+  KEYSTREAM GENERATORS
+
+  The cipher variant is generic in its PRNG: see CIPHER_HASH_FUNCS() below.
+  A generator G is a state type G_State and 2 inline funcs:
+
+    void G_seed(G_State * st, const uint64_t iv[2], uint64_t seed);
+    void G_fill(G_State * st, uint32_t * ks, uint32_t n_words);
+
+  G_fill() writes the next n_words <= CIPHER_KS_WORDS keystream words to ks,
+  and may write and consume up to its own granularity beyond n_words, which
+  is harmless because only the last fill of a message is short. G_seed()
+  tempers the iv and the seed the way the original Xoroshiro128+ variant
+  does, extended to larger states: word 2i of the state is SplitMix_next()
+  of iv[0]^seed plus i golden gammas, and word 2i+1 of iv[1] plus i gammas,
+  i.e. 2 splitmix64 streams. Word 0 and word 1 are exactly the original
+  tempered Xoroshiro128+ state.
+
+  The xorshift1024* and xoshiro256** next() funcs that follow were written in
+  2014-2018 by Sebastiano Vigna and David Blackman (vigna@acm.org), and
+  dedicated by them to the public domain (CC0), like Xoroshiro128Plus_next()
+  above. Ref: http://prng.di.unimi.it/
+*/
+
+#define SPLITMIX_GAMMA UINT64_C(0x9E3779B97F4A7C15)
+
+GCC_ATTRIB(nothrow,nonnull)
+INLINE void cipherTemper64(uint64_t * s, uint32_t n_words, const uint64_t iv[2], uint64_t seed)
+{
+  for (uint32_t i = 0; i < n_words; ++i) {
+    uint64_t x = (i & 1) ? iv[1] : iv[0]^seed;
+    s[i] = SplitMix_next(x + (i >> 1) * SPLITMIX_GAMMA);
+  }
+}
+
+// Every 64-bit draw is 2 keystream words, i.e. the layout of the original
+// variant, whatever the byte order.
+
+#define CIPHER_FILL64(G, NEXT) \
+GCC_ATTRIB(nothrow,nonnull,flatten) \
+INLINE void G##_fill(G##_State * st, uint32_t * ks, uint32_t n_words) \
+{ \
+  for (uint32_t w = 0; w < n_words; w += 2) { \
+    uint64_t r64 = NEXT(st); \
+    memcpy(ks + w, &r64, sizeof(r64)); \
+  } \
+}
+
+typedef struct {
+  uint64_t s[2];
+} Xoroshiro128Plus_State;
+
+GCC_ATTRIB(nothrow,nonnull)
+INLINE void Xoroshiro128Plus_seed(Xoroshiro128Plus_State * st, const uint64_t iv[2], uint64_t seed)
+{
+  cipherTemper64(st->s, 2, iv, seed);
+}
+
+GCC_ATTRIB(nothrow,nonnull)
+INLINE uint64_t Xoroshiro128Plus_draw(Xoroshiro128Plus_State * st)
+{
+  return Xoroshiro128Plus_next(st->s);
+}
+
+CIPHER_FILL64(Xoroshiro128Plus, Xoroshiro128Plus_draw)
+
+// xorshift1024*: 2^1024 - 1 period, 16 words of state. This is the
+// "xorshift1024*phi" version with the golden ratio multiplier.
+
+typedef struct {
+  uint64_t s[16];
+  uint32_t p;
+} Xorshift1024Star_State;
+
+GCC_ATTRIB(nothrow,nonnull)
+INLINE void Xorshift1024Star_seed(Xorshift1024Star_State * st, const uint64_t iv[2], uint64_t seed)
+{
+  cipherTemper64(st->s, 16, iv, seed);
+  st->p = 0;
+}
+
+GCC_ATTRIB(nothrow,nonnull)
+INLINE uint64_t Xorshift1024Star_next(Xorshift1024Star_State * st)
+{
+  const uint64_t s0 = st->s[st->p];
+  uint64_t s1 = st->s[st->p = (st->p + 1) & 15];
+  s1 ^= s1 << 31; // a
+  st->s[st->p] = s1 ^ s0 ^ (s1 >> 11) ^ (s0 >> 30); // b, c
+  return st->s[st->p] * UINT64_C(0x9e3779b97f4a7c13);
+}
+
+CIPHER_FILL64(Xorshift1024Star, Xorshift1024Star_next)
+
+// xoshiro256**: 2^256 - 1 period, 4 words of state, all bits pass.
+
+typedef struct {
+  uint64_t s[4];
+} Xoshiro256StarStar_State;
+
+GCC_ATTRIB(nothrow,nonnull)
+INLINE void Xoshiro256StarStar_seed(Xoshiro256StarStar_State * st, const uint64_t iv[2], uint64_t seed)
+{
+  cipherTemper64(st->s, 4, iv, seed);
+}
+
+GCC_ATTRIB(nothrow,nonnull)
+INLINE uint64_t Xoshiro256StarStar_next(Xoshiro256StarStar_State * st)
+{
+  uint64_t * s = st->s;
+  const uint64_t result = rotl64(s[1] * 5, 7) * 9;
+  const uint64_t t = s[1] << 17;
+
+  s[2] ^= s[0];
+  s[3] ^= s[1];
+  s[1] ^= s[2];
+  s[0] ^= s[3];
+  s[2] ^= t;
+  s[3] = rotl64(s[3], 45);
+
+  return result;
+}
+
+CIPHER_FILL64(Xoshiro256StarStar, Xoshiro256StarStar_next)
+
+#undef CIPHER_FILL64
+
+/*
+  32-BIT GENERATORS
+
+  For the native 32-bit cipher variant, which must not touch 64-bit
+  arithmetic in its hot loop on 32-bit targets.
+
+  Xoroshiro64StarStar_next() was written in 2018 by David Blackman and
+  Sebastiano Vigna (vigna@acm.org), and dedicated by them to the public
+  domain (CC0). Ref: http://prng.di.unimi.it/ It is their recommended 32-bit
+  generator for 32-bit outputs: 2^64 - 1 period, and all bits pass.
+
+  SplitMix32_next() is our 32-bit counterpart of SplitMix_next() for
+  tempering the iv: a golden ratio increment followed by the fmix32
+  finalizer of Austin Appleby's MurmurHash3 (public domain).
+*/
+
+GCC_ATTRIB(nothrow,nonnull)
+INLINE uint32_t Xoroshiro64StarStar_next(uint32_t * s)
+{
+  const uint32_t s0 = s[0];
+  uint32_t s1 = s[1];
+  const uint32_t result = rotl32(s0 * UINT32_C(0x9E3779BB), 5) * 5;
+
+  s1 ^= s0;
+  s[0] = rotl32(s0, 26) ^ s1 ^ (s1 << 9); // a, b
+  s[1] = rotl32(s1, 13); // c
+
+  return result;
+}
+
+GCC_ATTRIB(nothrow,const)
+static uint32_t SplitMix32_next(uint32_t x)
+{
+  uint32_t z = x + UINT32_C(0x9E3779B9);
+  z = (z ^ (z >> 16)) * UINT32_C(0x85EBCA6B);
+  z = (z ^ (z >> 13)) * UINT32_C(0xC2B2AE35);
+  return z ^ (z >> 16);
+}
+
 GCC_ATTRIB(nothrow,nonnull,unused,pure)
 static uint32_t Adler32(const uint8_t * msg, uint32_t n)
 {
@@ -222,230 +448,4106 @@ static uint32_t Adler32(const uint8_t * msg, uint32_t n)
   return adler_sum;
 }
 
+/*
+  KERNELS
+
+  All the time goes into the weighted sum of a block, or of the span of a
+  block which starts at word pos of the block:
+
+    adler_sum = (pos+1)*msg[0] + (pos+2)*msg[1] + ... + (pos+len)*msg[len-1]
+
+  mod 2^32 for AYBern_adlerHash32() (pos + len <= 2^9 uint16_t) and mod 2^64
+  for AYBern_adlerHash64() (pos + len <= 2^17 uint32_t). pos is 0 for a whole
+  block; the streaming API uses it to continue a block across update() calls.
+  msg is a byte pointer with no alignment requirement, and the words are
+  loaded in native byte order.
+  Each sum has a scalar version
+  and SSE4.1/AVX2/AVX-512 versions which are compiled with GCC "target"
+  attributes, so that one generic binary contains all of them. The best set
+  that the CPU supports is selected once at load time by adlerKernelInit().
+  Every version must return identical sums for every len, including the
+  partial last block.
+*/
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define AYBERN_X86 1
+#include <immintrin.h>
+#endif
+
+#define ADLER32_SHIFT 19 // 33 - 6 - 8
+#define ADLER32_BLOCK_LEN (UINT32_C(1) << (ADLER32_SHIFT >> 1)) // 2^9 uint16_t = 2^10 bytes
+
+#define ADLER64_SHIFT 35 // 65 - 6 - 8 - 16
+#define ADLER64_BLOCK_LEN (UINT32_C(1) << (ADLER64_SHIFT >> 1)) // 2^17 uint32_t = 2^19 bytes = 512K bytes
+
+#define ADLER_SHORT_BYTES 64 // one cache line
+
+#define CIPHER_KS_WORDS 256 // keystream buffer: 128 draws, 1K bytes
+#define CIPHER_LANES 8 // independent PRNG states of the cipher batch API
+
 GCC_ATTRIB(nothrow,nonnull,pure)
-uint32_t AYBern_adlerHash32(const uint16_t * msg, uint32_t n)
+static uint32_t adlerSum32_scalar(const uint8_t * msg, uint32_t len, uint32_t pos)
 {
-  uint32_t hash_code = 0;
+  uint32_t adler_sum = 0;
 
-  const int32_t shift = 19; // 33 - 6 - 8
-  const uint32_t block_len = 1 << (shift >> 1); // 2^9 uint16_t = 2^10 bytes
+  for (uint32_t i = 0; i < len; ++i) {
+    adler_sum += (pos+i+1) * load16(msg + 2*i);
+  }
 
-  uint32_t len = block_len;
-  uint32_t n_blocks = n/block_len;
-  uint32_t last_block_len = n & (block_len-1);
-  if (last_block_len) ++n_blocks;
+  return adler_sum;
+}
+
+GCC_ATTRIB(nothrow,nonnull,pure)
+static uint64_t adlerSum64_scalar(const uint8_t * msg, uint32_t len, uint32_t pos)
+{
+  uint64_t adler_sum = 0;
+
+  for (uint32_t i = 0; i < len; ++i) {
+    adler_sum += (uint64_t)(pos+i+1) * (uint64_t)load32(msg + 4*i);
+  }
+
+  return adler_sum;
+}
+
+// The wide hash64 sum: k interleaved lanes, lane l being words l, l+k, l+2k,
+// ... with lane local weights 1, 2, 3, ..., i.e. every lane is the
+// adlerSum64 of its own stride. It takes the first 16*n_vecs words of a
+// block, and adds lane l's sum to sums[l]. k is 4 or 8.
+
+GCC_ATTRIB(nothrow,nonnull)
+static void adlerWideSum64_scalar(const uint8_t * msg, uint32_t n_vecs, uint32_t k, uint64_t * sums)
+{
+  for (uint32_t i = 0; i < 16*n_vecs; ++i) {
+    sums[i & (k-1)] += (uint64_t)(i/k + 1) * (uint64_t)load32(msg + 4*i);
+  }
+}
+
+// The cipher sum, given the keystream: ks[i] is the PRNG mask of word i, i.e.
+// the keystream is the sequence of 64-bit draws read as uint32_t's. Every
+// cipher sum goes through it, see CIPHER_HASH_FUNCS(). It has no parity and no
+// serial PRNG state, so pos need not be even.
+
+GCC_ATTRIB(nothrow,nonnull,pure)
+static uint64_t cipherXorSum64_scalar(const uint8_t * msg, const uint32_t * ks, uint32_t len, uint32_t pos)
+{
+  uint64_t adler_sum = 0;
+
+  for (uint32_t i = 0; i < len; ++i) {
+    adler_sum += (uint64_t)(pos+i+1) * (uint64_t)(load32(msg + 4*i) ^ ks[i]);
+  }
+
+  return adler_sum;
+}
+
+// The fused encrypt-and-hash sum: out[i] = in[i] ^ ks_out[i] is stored, and
+// the cipher sum is taken of in[i] ^ ks_sum[i], so that a single pass over
+// the message both encrypts (or decrypts) and hashes it. in and out may be
+// the same buffer.
+
+GCC_ATTRIB(nothrow,nonnull)
+static uint64_t cipherXorCrypt64_scalar(const uint8_t * in, uint8_t * out, const uint32_t * ks_out,
+    const uint32_t * ks_sum, uint32_t len, uint32_t pos)
+{
+  uint64_t adler_sum = 0;
+
+  for (uint32_t i = 0; i < len; ++i) {
+    uint32_t w = load32(in + 4*i);
+    uint32_t x = w ^ ks_out[i];
+    memcpy(out + 4*i, &x, sizeof(x));
+    adler_sum += (uint64_t)(pos+i+1) * (uint64_t)(w ^ ks_sum[i]);
+  }
+
+  return adler_sum;
+}
+
+// Copy-and-hash: the sum kernels, which also store every word they load to
+// out, so that a copy and its digest take one pass over memory. nt asks for
+// non-temporal stores, which bypass the cache, for a destination which will
+// not be read soon; the SIMD kernels only use them when out is aligned to
+// the vector size, and the caller issues the store fence. in and out must
+// not overlap.
+
+GCC_ATTRIB(nothrow,nonnull)
+static uint32_t adlerCopySum32_scalar(const uint8_t * in, uint8_t * out, uint32_t len, uint32_t pos, int nt)
+{
+  uint32_t adler_sum = 0;
+  (void)nt;
+
+  for (uint32_t i = 0; i < len; ++i) {
+    uint16_t w = load16(in + 2*i);
+    memcpy(out + 2*i, &w, sizeof(w));
+    adler_sum += (pos+i+1) * w;
+  }
+
+  return adler_sum;
+}
+
+GCC_ATTRIB(nothrow,nonnull)
+static uint64_t adlerCopySum64_scalar(const uint8_t * in, uint8_t * out, uint32_t len, uint32_t pos, int nt)
+{
+  uint64_t adler_sum = 0;
+  (void)nt;
+
+  for (uint32_t i = 0; i < len; ++i) {
+    uint32_t w = load32(in + 4*i);
+    memcpy(out + 4*i, &w, sizeof(w));
+    adler_sum += (uint64_t)(pos+i+1) * (uint64_t)w;
+  }
+
+  return adler_sum;
+}
+
+// the cipher sum of the copied words, with the keystream ks
+
+GCC_ATTRIB(nothrow,nonnull)
+static uint64_t cipherCopySum64_scalar(const uint8_t * in, uint8_t * out, const uint32_t * ks,
+    uint32_t len, uint32_t pos, int nt)
+{
+  uint64_t adler_sum = 0;
+  (void)nt;
+
+  for (uint32_t i = 0; i < len; ++i) {
+    uint32_t w = load32(in + 4*i);
+    memcpy(out + 4*i, &w, sizeof(w));
+    adler_sum += (uint64_t)(pos+i+1) * (uint64_t)(w ^ ks[i]);
+  }
+
+  return adler_sum;
+}
+
+// The cipher batch keystream: n_draws draws of each of CIPHER_LANES
+// independent PRNG states, whose lane l is (s0[l], s1[l]), into ks[l] in the
+// layout of Xoroshiro128Plus_fill(). n_draws <= CIPHER_KS_WORDS/2. The SIMD
+// versions may round n_draws up to a multiple of 4, which the caller allows
+// for, since it only asks for less than a full buffer for lanes whose
+// messages end in it.
+
+GCC_ATTRIB(nothrow,nonnull)
+static void cipherKeystream8_scalar(uint64_t * s0, uint64_t * s1, uint32_t (*ks)[CIPHER_KS_WORDS], uint32_t n_draws)
+{
+  for (uint32_t l = 0; l < CIPHER_LANES; ++l) {
+    uint64_t s[2] = { s0[l], s1[l] };
+    for (uint32_t d = 0; d < n_draws; ++d) {
+      uint64_t r64 = Xoroshiro128Plus_next(s);
+      memcpy(ks[l] + 2*d, &r64, sizeof(r64));
+    }
+    s0[l] = s[0];
+    s1[l] = s[1];
+  }
+}
+
+// The v2 cipher keystream: the same 8 lanes, but interleaved rather than
+// one buffer per lane. Draw d of lane l is ks[16*d + 2*l ..], so that lane
+// l masks word pair l of every 16-word (64-byte) group. n_draws is per lane,
+// i.e. 16*n_draws words.
+
+GCC_ATTRIB(nothrow,nonnull)
+static void cipherKeystreamV2_scalar(uint64_t * s0, uint64_t * s1, uint32_t * ks, uint32_t n_draws)
+{
+  for (uint32_t d = 0; d < n_draws; ++d) {
+    for (uint32_t l = 0; l < CIPHER_LANES; ++l) {
+      uint64_t s[2] = { s0[l], s1[l] };
+      uint64_t r64 = Xoroshiro128Plus_next(s);
+      memcpy(ks + 16*d + 2*l, &r64, sizeof(r64));
+      s0[l] = s[0];
+      s1[l] = s[1];
+    }
+  }
+}
+
+// The v2 cipher sum of len words starting at word pos of a block, with the
+// keystream generated in step: one draw of every lane per 16-word group.
+// len is a multiple of 16, and pos too, so the groups stay aligned with the
+// lanes.
+
+GCC_ATTRIB(nothrow,nonnull)
+static uint64_t cipherV2Sum64_scalar(const uint8_t * msg, uint32_t len, uint32_t pos, uint64_t * s0, uint64_t * s1)
+{
+  uint64_t adler_sum = 0;
+  uint32_t ks[16];
+
+  for (uint32_t i = 0; i < len; i += 16) {
+    cipherKeystreamV2_scalar(s0, s1, ks, 1);
+    adler_sum += cipherXorSum64_scalar(msg + 4*i, ks, 16, pos + i);
+  }
+
+  return adler_sum;
+}
+
+// ChaCha8: 8 consecutive 64-byte blocks of Bernstein's ChaCha with 8 rounds,
+// i.e. the block counter in[12] + 0..7, into out[0..127]. The input block
+// is the original layout: 4 constant words, 8 key words, a 64-bit counter in
+// words 12-13 and a 64-bit nonce in words 14-15. The caller keeps in[12] a
+// multiple of 8, so the 8 counters never carry into in[13].
+
+#define CHACHA_ROUNDS 8
+
+#define CHACHA_QR(a, b, c, d) \
+  do { \
+    a += b; d = rotl32(d ^ a, 16); \
+    c += d; b = rotl32(b ^ c, 12); \
+    a += b; d = rotl32(d ^ a, 8); \
+    c += d; b = rotl32(b ^ c, 7); \
+  } while (0)
+
+GCC_ATTRIB(nothrow,nonnull)
+static void chacha8Blocks8_scalar(const uint32_t * in, uint32_t * out)
+{
+  for (uint32_t b = 0; b < 8; ++b, out += 16) {
+    uint32_t x[16];
+    memcpy(x, in, sizeof(x));
+    x[12] += b;
+
+    for (int r = 0; r < CHACHA_ROUNDS; r += 2) {
+      CHACHA_QR(x[0], x[4], x[8], x[12]);
+      CHACHA_QR(x[1], x[5], x[9], x[13]);
+      CHACHA_QR(x[2], x[6], x[10], x[14]);
+      CHACHA_QR(x[3], x[7], x[11], x[15]);
+      CHACHA_QR(x[0], x[5], x[10], x[15]);
+      CHACHA_QR(x[1], x[6], x[11], x[12]);
+      CHACHA_QR(x[2], x[7], x[8], x[13]);
+      CHACHA_QR(x[3], x[4], x[9], x[14]);
+    }
+
+    for (int i = 0; i < 16; ++i) out[i] = x[i] + in[i];
+    out[12] += b;
+  }
+}
+
+#undef CHACHA_QR
+
+// AES-128 in counter mode: 8 consecutive counter blocks, 32 keystream
+// words. rk is the expanded key, 11 round keys of 16 bytes in FIPS-197
+// byte order. Counter block i is the 64-bit ctr + i followed by the 64-bit
+// nonce, both little endian. The scalar version is a plain byte oriented
+// software AES, which is slow, and is there for testing and for CPUs
+// without AES-NI.
+
+static const uint8_t aes_sbox[256] = {
+  0x63,0x7c,0x77,0x7b,0xf2,0x6b,0x6f,0xc5,0x30,0x01,0x67,0x2b,0xfe,0xd7,0xab,0x76,
+  0xca,0x82,0xc9,0x7d,0xfa,0x59,0x47,0xf0,0xad,0xd4,0xa2,0xaf,0x9c,0xa4,0x72,0xc0,
+  0xb7,0xfd,0x93,0x26,0x36,0x3f,0xf7,0xcc,0x34,0xa5,0xe5,0xf1,0x71,0xd8,0x31,0x15,
+  0x04,0xc7,0x23,0xc3,0x18,0x96,0x05,0x9a,0x07,0x12,0x80,0xe2,0xeb,0x27,0xb2,0x75,
+  0x09,0x83,0x2c,0x1a,0x1b,0x6e,0x5a,0xa0,0x52,0x3b,0xd6,0xb3,0x29,0xe3,0x2f,0x84,
+  0x53,0xd1,0x00,0xed,0x20,0xfc,0xb1,0x5b,0x6a,0xcb,0xbe,0x39,0x4a,0x4c,0x58,0xcf,
+  0xd0,0xef,0xaa,0xfb,0x43,0x4d,0x33,0x85,0x45,0xf9,0x02,0x7f,0x50,0x3c,0x9f,0xa8,
+  0x51,0xa3,0x40,0x8f,0x92,0x9d,0x38,0xf5,0xbc,0xb6,0xda,0x21,0x10,0xff,0xf3,0xd2,
+  0xcd,0x0c,0x13,0xec,0x5f,0x97,0x44,0x17,0xc4,0xa7,0x7e,0x3d,0x64,0x5d,0x19,0x73,
+  0x60,0x81,0x4f,0xdc,0x22,0x2a,0x90,0x88,0x46,0xee,0xb8,0x14,0xde,0x5e,0x0b,0xdb,
+  0xe0,0x32,0x3a,0x0a,0x49,0x06,0x24,0x5c,0xc2,0xd3,0xac,0x62,0x91,0x95,0xe4,0x79,
+  0xe7,0xc8,0x37,0x6d,0x8d,0xd5,0x4e,0xa9,0x6c,0x56,0xf4,0xea,0x65,0x7a,0xae,0x08,
+  0xba,0x78,0x25,0x2e,0x1c,0xa6,0xb4,0xc6,0xe8,0xdd,0x74,0x1f,0x4b,0xbd,0x8b,0x8a,
+  0x70,0x3e,0xb5,0x66,0x48,0x03,0xf6,0x0e,0x61,0x35,0x57,0xb9,0x86,0xc1,0x1d,0x9e,
+  0xe1,0xf8,0x98,0x11,0x69,0xd9,0x8e,0x94,0x9b,0x1e,0x87,0xe9,0xce,0x55,0x28,0xdf,
+  0x8c,0xa1,0x89,0x0d,0xbf,0xe6,0x42,0x68,0x41,0x99,0x2d,0x0f,0xb0,0x54,0xbb,0x16,
+};
+
+GCC_ATTRIB(nothrow,const)
+INLINE uint8_t aesXtime(uint8_t x)
+{
+  return (uint8_t)((x << 1) ^ ((x >> 7) * 0x1b));
+}
+
+GCC_ATTRIB(nothrow,nonnull)
+static void aesExpandKey128(const uint8_t key[16], uint8_t rk[176])
+{
+  uint8_t rcon = 1;
+
+  memcpy(rk, key, 16);
+
+  for (int i = 16; i < 176; i += 4) {
+    uint8_t t[4] = { rk[i-4], rk[i-3], rk[i-2], rk[i-1] };
+    if (i % 16 == 0) { // RotWord, SubWord, Rcon
+      uint8_t t0 = t[0];
+      t[0] = aes_sbox[t[1]] ^ rcon;
+      t[1] = aes_sbox[t[2]];
+      t[2] = aes_sbox[t[3]];
+      t[3] = aes_sbox[t0];
+      rcon = aesXtime(rcon);
+    }
+    for (int b = 0; b < 4; ++b) rk[i+b] = rk[i-16+b] ^ t[b];
+  }
+}
+
+GCC_ATTRIB(nothrow,nonnull)
+static void aesEncrypt128_scalar(const uint8_t * rk, uint8_t s[16])
+{
+  for (int b = 0; b < 16; ++b) s[b] ^= rk[b];
+
+  for (int r = 1; r <= 10; ++r) {
+    uint8_t t[16];
+    for (int c = 0; c < 4; ++c) { // SubBytes and ShiftRows: byte (row, col) is s[row + 4*col]
+      for (int row = 0; row < 4; ++row) t[row + 4*c] = aes_sbox[s[row + 4*((c + row) & 3)]];
+    }
+    if (r < 10) { // MixColumns
+      for (int c = 0; c < 4; ++c) {
+        uint8_t * a = t + 4*c;
+        uint8_t all = a[0] ^ a[1] ^ a[2] ^ a[3];
+        uint8_t a0 = a[0];
+        a[0] ^= all ^ aesXtime(a[0] ^ a[1]);
+        a[1] ^= all ^ aesXtime(a[1] ^ a[2]);
+        a[2] ^= all ^ aesXtime(a[2] ^ a[3]);
+        a[3] ^= all ^ aesXtime(a[3] ^ a0);
+      }
+    }
+    for (int b = 0; b < 16; ++b) s[b] = t[b] ^ rk[16*r + b];
+  }
+}
+
+GCC_ATTRIB(nothrow,nonnull)
+static void aesCtr8_scalar(const uint8_t * rk, uint64_t ctr, uint64_t nonce, uint32_t * out)
+{
+  for (uint32_t i = 0; i < 8; ++i) {
+    uint8_t blk[16];
+    for (int b = 0; b < 8; ++b) {
+      blk[b] = (uint8_t)((ctr + i) >> (8*b));
+      blk[8+b] = (uint8_t)(nonce >> (8*b));
+    }
+    aesEncrypt128_scalar(rk, blk);
+    memcpy(out + 4*i, blk, sizeof(blk));
+  }
+}
+
+// The short sums are the whole-message sums of 1 to ADLER_SHORT_BYTES byte
+// messages, with the zero padded tail word of the Mem API. The AVX-512
+// versions are branchless: a single fault suppressing masked load of the
+// message, which zero fills the rest of the cache line, and a fixed multiply
+// by the weights, since a zero word adds nothing whatever its weight.
+
+GCC_ATTRIB(nothrow,nonnull,pure)
+static uint32_t adlerShortSum32_scalar(const uint8_t * msg, uint32_t n_bytes)
+{
+  uint32_t adler_sum = 0;
+  uint32_t i;
+
+  for (i = 0; 2*i + 2 <= n_bytes; ++i) {
+    adler_sum += (i+1) * load16(msg + 2*i);
+  }
+
+  if (n_bytes & 1) {
+    uint8_t pad[2] = { msg[2*i], 0 };
+    adler_sum += (i+1) * load16(pad);
+  }
+
+  return adler_sum;
+}
+
+GCC_ATTRIB(nothrow,nonnull,pure)
+static uint64_t adlerShortSum64_scalar(const uint8_t * msg, uint32_t n_bytes)
+{
+  uint64_t adler_sum = 0;
+  uint32_t i;
+
+  for (i = 0; 4*i + 4 <= n_bytes; ++i) {
+    adler_sum += (uint64_t)(i+1) * (uint64_t)load32(msg + 4*i);
+  }
+
+  if (n_bytes & 3) {
+    uint8_t pad[4] = { 0, 0, 0, 0 };
+    memcpy(pad, msg + 4*i, n_bytes & 3);
+    adler_sum += (uint64_t)(i+1) * (uint64_t)load32(pad);
+  }
+
+  return adler_sum;
+}
+
+// The real, zlib compatible, Adler-32 (RFC 1950), unlike the Adler32() toy
+// above: s1 = 1 + the sum of the bytes and s2 = the sum of the s1's, both
+// mod 65521, packed as s2:s1. ZLIB_NMAX is the most bytes that can be
+// summed before s2 could overflow 32 bits, so the mods are only taken
+// every ZLIB_NMAX bytes.
+
+#define ZLIB_BASE UINT32_C(65521) // the largest prime < 2^16
+#define ZLIB_NMAX 5552
+
+GCC_ATTRIB(nothrow,nonnull,pure)
+static uint32_t zlibAdler32_scalar(uint32_t adler, const uint8_t * msg, size_t n_bytes)
+{
+  uint32_t s1 = adler & 0xffff;
+  uint32_t s2 = adler >> 16;
+
+  while (n_bytes) {
+    size_t len = (n_bytes < ZLIB_NMAX) ? n_bytes : ZLIB_NMAX;
+    n_bytes -= len;
+    for (size_t i = 0; i < len; ++i) {
+      s1 += msg[i];
+      s2 += s1;
+    }
+    msg += len;
+    s1 %= ZLIB_BASE;
+    s2 %= ZLIB_BASE;
+  }
+
+  return s1 | (s2 << 16);
+}
+
+#ifdef AYBERN_X86
+
+/*
+  adlerSum32: pmaddwd multiplies pairs of *signed* 16-bit words and adds the
+  two 32-bit products. The weights (pos+i+1) <= 2^9 fit in an int16, but the
+  message words do not, so we bias them: msg = (int16_t)(msg ^ 0x8000) + 0x8000.
+  The bias contributes 0x8000 * (sum of the weights) which we add back after
+  the loop. |product| <= 2^15 * (2^9 + 2^6), so no pair sum overflows an int32
+  lane, and the lane sums themselves may wrap since we want the sum mod 2^32.
+
+  adlerSum64: every product is < 2^49, so it is exact in a 64-bit lane. We
+  keep per-lane partial sums for the even and for the odd words, weighted with
+  vpmuludq (which only looks at the low 32 bits of each 64-bit lane), and only
+  reduce them at the end of the block. With IFMA, vpmadd52luq fuses the
+  multiply and the add, which is exact because the products fit in 52 bits.
+*/
+
+// Horizontal sums. The vector adds wrap, which is what we want, whereas
+// _mm512_reduce_add_*() is specified with signed (overflowing) arithmetic.
+
+// The sum of the 2 64-bit lanes, through a store rather than pextrq, which
+// does not exist in 32-bit mode.
+
+GCC_ATTRIB(nothrow,const,target("sse4.1"))
+INLINE uint64_t hsum128Epi64(__m128i x)
+{
+  uint64_t sum;
+  _mm_storel_epi64((__m128i *)&sum, _mm_add_epi64(x, _mm_unpackhi_epi64(x, x)));
+  return sum;
+}
+
+GCC_ATTRIB(nothrow,const,target("avx512f"))
+INLINE uint32_t hsum512Epi32(__m512i v)
+{
+  __m256i x = _mm256_add_epi32(_mm512_castsi512_si256(v), _mm512_extracti64x4_epi64(v, 1));
+  __m128i y = _mm_add_epi32(_mm256_castsi256_si128(x), _mm256_extracti128_si256(x, 1));
+  y = _mm_add_epi32(y, _mm_shuffle_epi32(y, _MM_SHUFFLE(1,0,3,2)));
+  y = _mm_add_epi32(y, _mm_shuffle_epi32(y, _MM_SHUFFLE(2,3,0,1)));
+  return (uint32_t)_mm_cvtsi128_si32(y);
+}
+
+GCC_ATTRIB(nothrow,const,target("avx512f"))
+INLINE uint64_t hsum512Epi64(__m512i v)
+{
+  __m256i x = _mm256_add_epi64(_mm512_castsi512_si256(v), _mm512_extracti64x4_epi64(v, 1));
+  __m128i y = _mm_add_epi64(_mm256_castsi256_si128(x), _mm256_extracti128_si256(x, 1));
+  return hsum128Epi64(y);
+}
+
+GCC_ATTRIB(nothrow,nonnull,pure,target("sse4.1"))
+static uint32_t adlerSum32_sse41(const uint8_t * msg, uint32_t len, uint32_t pos)
+{
+  const __m128i bias = _mm_set1_epi16((short)0x8000);
+  const __m128i step = _mm_set1_epi16(8);
+  __m128i w = _mm_add_epi16(_mm_set1_epi16((short)pos), _mm_setr_epi16(1,2,3,4,5,6,7,8));
+  __m128i acc0 = _mm_setzero_si128();
+  __m128i acc1 = _mm_setzero_si128();
+
+  uint32_t i = 0;
+
+  for (; i + 16 <= len; i += 16) {
+    __m128i v0 = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(msg + 2*i)), bias);
+    __m128i v1 = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(msg + 2*i + 16)), bias);
+    acc0 = _mm_add_epi32(acc0, _mm_madd_epi16(v0, w));
+    w = _mm_add_epi16(w, step);
+    acc1 = _mm_add_epi32(acc1, _mm_madd_epi16(v1, w));
+    w = _mm_add_epi16(w, step);
+  }
+
+  if (i + 8 <= len) {
+    __m128i v0 = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(msg + 2*i)), bias);
+    acc0 = _mm_add_epi32(acc0, _mm_madd_epi16(v0, w));
+    i += 8;
+  }
+
+  __m128i x = _mm_add_epi32(acc0, acc1);
+  x = _mm_add_epi32(x, _mm_shuffle_epi32(x, _MM_SHUFFLE(1,0,3,2)));
+  x = _mm_add_epi32(x, _mm_shuffle_epi32(x, _MM_SHUFFLE(2,3,0,1)));
+
+  uint32_t adler_sum = (uint32_t)_mm_cvtsi128_si32(x);
+  adler_sum += UINT32_C(0x8000) * (i * pos + i * (i + 1) / 2); // remove the bias
+
+  for (; i < len; ++i) { // tail: less than 8 words
+    adler_sum += (pos+i+1) * load16(msg + 2*i);
+  }
+
+  return adler_sum;
+}
+
+GCC_ATTRIB(nothrow,nonnull,pure,target("avx2"))
+static uint32_t adlerSum32_avx2(const uint8_t * msg, uint32_t len, uint32_t pos)
+{
+  const __m256i bias = _mm256_set1_epi16((short)0x8000);
+  const __m256i step = _mm256_set1_epi16(16);
+  __m256i w = _mm256_add_epi16(_mm256_set1_epi16((short)pos),
+    _mm256_setr_epi16(1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,16));
+  __m256i acc0 = _mm256_setzero_si256();
+  __m256i acc1 = _mm256_setzero_si256();
+
+  uint32_t i = 0;
+
+  for (; i + 32 <= len; i += 32) { // 2 independent accumulators hide the madd latency
+    __m256i v0 = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)(msg + 2*i)), bias);
+    __m256i v1 = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)(msg + 2*i + 32)), bias);
+    acc0 = _mm256_add_epi32(acc0, _mm256_madd_epi16(v0, w));
+    w = _mm256_add_epi16(w, step);
+    acc1 = _mm256_add_epi32(acc1, _mm256_madd_epi16(v1, w));
+    w = _mm256_add_epi16(w, step);
+  }
+
+  if (i + 16 <= len) {
+    __m256i v0 = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)(msg + 2*i)), bias);
+    acc0 = _mm256_add_epi32(acc0, _mm256_madd_epi16(v0, w));
+    i += 16;
+  }
+
+  // horizontal sum of the 8 lanes
+
+  __m256i acc = _mm256_add_epi32(acc0, acc1);
+  __m128i x = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+  x = _mm_add_epi32(x, _mm_shuffle_epi32(x, _MM_SHUFFLE(1,0,3,2)));
+  x = _mm_add_epi32(x, _mm_shuffle_epi32(x, _MM_SHUFFLE(2,3,0,1)));
+
+  uint32_t adler_sum = (uint32_t)_mm_cvtsi128_si32(x);
+  adler_sum += UINT32_C(0x8000) * (i * pos + i * (i + 1) / 2); // remove the bias
+
+  for (; i < len; ++i) { // tail: less than 16 words
+    adler_sum += (pos+i+1) * load16(msg + 2*i);
+  }
+
+  return adler_sum;
+}
+
+GCC_ATTRIB(nothrow,nonnull,pure,target("avx512f,avx512bw"))
+static uint32_t adlerSum32_avx512(const uint8_t * msg, uint32_t len, uint32_t pos)
+{
+  const __m512i bias = _mm512_set1_epi16((short)0x8000);
+  const __m512i step = _mm512_set1_epi16(32);
+  __m512i w = _mm512_add_epi16(_mm512_set1_epi16((short)pos),
+    _mm512_set_epi16(32,31,30,29,28,27,26,25,24,23,22,21,20,19,18,17,
+    16,15,14,13,12,11,10,9,8,7,6,5,4,3,2,1));
+  __m512i acc0 = _mm512_setzero_si512();
+
+  uint32_t i = 0;
+
+  for (; i < len; i += 32) {
+    // the masked-off words of the last vector get zero weight, so that the
+    // bias correction below is exactly 0x8000 * len(len+1)/2
+    uint32_t rest = len - i;
+    __mmask32 m = (rest >= 32) ? (__mmask32)0xffffffff : (__mmask32)((UINT32_C(1) << rest) - 1);
+    __m512i v0 = _mm512_xor_si512(_mm512_maskz_loadu_epi16(m, (const void *)(msg + 2*i)), bias);
+    acc0 = _mm512_add_epi32(acc0, _mm512_madd_epi16(v0, _mm512_maskz_mov_epi16(m, w)));
+    w = _mm512_add_epi16(w, step);
+  }
+
+  uint32_t adler_sum = hsum512Epi32(acc0);
+  adler_sum += UINT32_C(0x8000) * (len * pos + len * (len + 1) / 2); // remove the bias
+
+  return adler_sum;
+}
+
+GCC_ATTRIB(nothrow,nonnull,pure,target("sse4.1"))
+static uint64_t adlerSum64_sse41(const uint8_t * msg, uint32_t len, uint32_t pos)
+{
+  const __m128i step = _mm_set1_epi64x(4);
+  __m128i w_even = _mm_add_epi64(_mm_set1_epi64x(pos), _mm_set_epi64x(3,1)); // weights of msg[0], msg[2]
+  __m128i w_odd = _mm_add_epi64(_mm_set1_epi64x(pos), _mm_set_epi64x(4,2)); // weights of msg[1], msg[3]
+  __m128i acc0 = _mm_setzero_si128();
+  __m128i acc1 = _mm_setzero_si128();
+
+  uint32_t i = 0;
+
+  for (; i + 4 <= len; i += 4) {
+    __m128i v0 = _mm_loadu_si128((const __m128i *)(msg + 4*i));
+    acc0 = _mm_add_epi64(acc0, _mm_mul_epu32(v0, w_even));
+    acc1 = _mm_add_epi64(acc1, _mm_mul_epu32(_mm_srli_epi64(v0, 32), w_odd));
+    w_even = _mm_add_epi64(w_even, step);
+    w_odd = _mm_add_epi64(w_odd, step);
+  }
+
+  __m128i x = _mm_add_epi64(acc0, acc1);
+  uint64_t adler_sum = hsum128Epi64(x);
+
+  for (; i < len; ++i) { // tail: less than 4 words
+    adler_sum += (uint64_t)(pos+i+1) * (uint64_t)load32(msg + 4*i);
+  }
+
+  return adler_sum;
+}
+
+GCC_ATTRIB(nothrow,nonnull,pure,target("avx2"))
+static uint64_t adlerSum64_avx2(const uint8_t * msg, uint32_t len, uint32_t pos)
+{
+  const __m256i step = _mm256_set1_epi64x(8);
+  __m256i w_even = _mm256_add_epi64(_mm256_set1_epi64x(pos), _mm256_setr_epi64x(1,3,5,7)); // weights of msg[0], msg[2], ...
+  __m256i w_odd = _mm256_add_epi64(_mm256_set1_epi64x(pos), _mm256_setr_epi64x(2,4,6,8)); // weights of msg[1], msg[3], ...
+  __m256i acc0 = _mm256_setzero_si256();
+  __m256i acc1 = _mm256_setzero_si256();
+  __m256i acc2 = _mm256_setzero_si256();
+  __m256i acc3 = _mm256_setzero_si256();
+
+  uint32_t i = 0;
+
+  for (; i + 16 <= len; i += 16) {
+    __m256i v0 = _mm256_loadu_si256((const __m256i *)(msg + 4*i));
+    __m256i v1 = _mm256_loadu_si256((const __m256i *)(msg + 4*i + 32));
+    acc0 = _mm256_add_epi64(acc0, _mm256_mul_epu32(v0, w_even));
+    acc1 = _mm256_add_epi64(acc1, _mm256_mul_epu32(_mm256_srli_epi64(v0, 32), w_odd));
+    w_even = _mm256_add_epi64(w_even, step);
+    w_odd = _mm256_add_epi64(w_odd, step);
+    acc2 = _mm256_add_epi64(acc2, _mm256_mul_epu32(v1, w_even));
+    acc3 = _mm256_add_epi64(acc3, _mm256_mul_epu32(_mm256_srli_epi64(v1, 32), w_odd));
+    w_even = _mm256_add_epi64(w_even, step);
+    w_odd = _mm256_add_epi64(w_odd, step);
+  }
+
+  if (i + 8 <= len) {
+    __m256i v0 = _mm256_loadu_si256((const __m256i *)(msg + 4*i));
+    acc0 = _mm256_add_epi64(acc0, _mm256_mul_epu32(v0, w_even));
+    acc1 = _mm256_add_epi64(acc1, _mm256_mul_epu32(_mm256_srli_epi64(v0, 32), w_odd));
+    i += 8;
+  }
+
+  __m256i acc = _mm256_add_epi64(_mm256_add_epi64(acc0, acc1), _mm256_add_epi64(acc2, acc3));
+  __m128i x = _mm_add_epi64(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+  uint64_t adler_sum = hsum128Epi64(x);
+
+  for (; i < len; ++i) { // tail: less than 8 words
+    adler_sum += (uint64_t)(pos+i+1) * (uint64_t)load32(msg + 4*i);
+  }
+
+  return adler_sum;
+}
+
+/*
+  adlerWideSum64: there are no multiplies in the loop. Word e of a 16-word
+  vector t has the lane local weight G*t + e/k + 1, where G = 16/k is the
+  number of lane steps per vector, and so its lane's sum is
+
+    G * sum(t * x) + (e/k + 1) * sum(x)
+
+  Each of the 16 word positions keeps the running sum A = sum(x) and the sum
+  of the running sums B = sum((n - t) * x), whence sum(t * x) = n*A - B, all
+  mod 2^64. The even words need not be isolated: a 64-bit lane sums
+  even + 2^32 * odd, and its odd word sum is subtracted at the end. That is
+  a shift and 4 adds per 2 words in the loop, rather than 2 multiplies and
+  the weight updates, and adlerWideFinish64() turns the 16 (A, B) pairs into
+  the lane sums.
+*/
+
+GCC_ATTRIB(nothrow,nonnull)
+static void adlerWideFinish64(const uint64_t * a, const uint64_t * b, uint32_t n_vecs, uint32_t k, uint64_t * sums)
+{
+  const uint64_t g = 16/k;
+
+  for (uint32_t e = 0; e < 16; ++e) {
+    sums[e & (k-1)] += g * (n_vecs * a[e] - b[e]) + (e/k + 1) * a[e];
+  }
+}
+
+// the even word sums of whole 64-bit lane sums, see above
+#define ADLER_WIDE_EVEN(x, odd) ((x) - ((odd) << 32))
+
+GCC_ATTRIB(nothrow,nonnull,target("avx2"))
+static void adlerWideSum64_avx2(const uint8_t * msg, uint32_t n_vecs, uint32_t k, uint64_t * sums)
+{
+  __m256i a[4], b[4]; // whole and odd words of the 2 halves: e = 0,2,4,6 1,3,5,7 8,10,12,14 9,11,13,15
+  for (int r = 0; r < 4; ++r) a[r] = b[r] = _mm256_setzero_si256();
+
+  for (uint32_t t = 0; t < n_vecs; ++t, msg += 64) {
+    __m256i v0 = _mm256_loadu_si256((const __m256i *)msg);
+    __m256i v1 = _mm256_loadu_si256((const __m256i *)(msg + 32));
+    a[0] = _mm256_add_epi64(a[0], v0);
+    a[1] = _mm256_add_epi64(a[1], _mm256_srli_epi64(v0, 32));
+    a[2] = _mm256_add_epi64(a[2], v1);
+    a[3] = _mm256_add_epi64(a[3], _mm256_srli_epi64(v1, 32));
+    b[0] = _mm256_add_epi64(b[0], a[0]);
+    b[1] = _mm256_add_epi64(b[1], a[1]);
+    b[2] = _mm256_add_epi64(b[2], a[2]);
+    b[3] = _mm256_add_epi64(b[3], a[3]);
+  }
+
+  uint64_t ta[4][4], tb[4][4], ea[16], eb[16];
+  for (int r = 0; r < 4; ++r) {
+    _mm256_storeu_si256((__m256i *)ta[r], a[r]);
+    _mm256_storeu_si256((__m256i *)tb[r], b[r]);
+  }
+  for (int h = 0; h < 2; ++h) {
+    for (int q = 0; q < 4; ++q) {
+      uint32_t e = 8*h + 2*q;
+      ea[e] = ADLER_WIDE_EVEN(ta[2*h][q], ta[2*h + 1][q]);
+      eb[e] = ADLER_WIDE_EVEN(tb[2*h][q], tb[2*h + 1][q]);
+      ea[e + 1] = ta[2*h + 1][q];
+      eb[e + 1] = tb[2*h + 1][q];
+    }
+  }
+
+  adlerWideFinish64(ea, eb, n_vecs, k, sums);
+}
+
+GCC_ATTRIB(nothrow,nonnull,target("avx512f"))
+static void adlerWideSum64_avx512(const uint8_t * msg, uint32_t n_vecs, uint32_t k, uint64_t * sums)
+{
+  __m512i a_all = _mm512_setzero_si512(), a_odd = _mm512_setzero_si512();
+  __m512i b_all = _mm512_setzero_si512(), b_odd = _mm512_setzero_si512();
+
+  for (uint32_t t = 0; t < n_vecs; ++t, msg += 64) {
+    __m512i v = _mm512_loadu_si512((const void *)msg);
+    a_all = _mm512_add_epi64(a_all, v);
+    a_odd = _mm512_add_epi64(a_odd, _mm512_srli_epi64(v, 32));
+    b_all = _mm512_add_epi64(b_all, a_all);
+    b_odd = _mm512_add_epi64(b_odd, a_odd);
+  }
+
+  uint64_t ta[2][8], tb[2][8], ea[16], eb[16];
+  _mm512_storeu_si512((void *)ta[0], a_all);
+  _mm512_storeu_si512((void *)ta[1], a_odd);
+  _mm512_storeu_si512((void *)tb[0], b_all);
+  _mm512_storeu_si512((void *)tb[1], b_odd);
+  for (int q = 0; q < 8; ++q) {
+    ea[2*q] = ADLER_WIDE_EVEN(ta[0][q], ta[1][q]);
+    eb[2*q] = ADLER_WIDE_EVEN(tb[0][q], tb[1][q]);
+    ea[2*q + 1] = ta[1][q];
+    eb[2*q + 1] = tb[1][q];
+  }
+
+  adlerWideFinish64(ea, eb, n_vecs, k, sums);
+}
+
+#undef ADLER_WIDE_EVEN
+
+// The AVX-512 adlerSum64 is instantiated twice: with vpmuludq + vpaddq and
+// with IFMA. In the IFMA case the odd/even word must first be isolated in the
+// low 32 bits of the lane, since vpmadd52luq looks at 52 bits.
+
+#define ADLER_SUM64_AVX512(NAME, TARGET, MADD_EVEN, MADD_ODD) \
+GCC_ATTRIB(nothrow,nonnull,pure,target(TARGET)) \
+static uint64_t NAME(const uint8_t * msg, uint32_t len, uint32_t pos) \
+{ \
+  const __m512i lo32 GCC_ATTRIB(unused) = _mm512_set1_epi64(0xffffffff); \
+  const __m512i step = _mm512_set1_epi64(16); \
+  __m512i w_even = _mm512_add_epi64(_mm512_set1_epi64(pos), _mm512_setr_epi64(1,3,5,7,9,11,13,15)); \
+  __m512i w_odd = _mm512_add_epi64(_mm512_set1_epi64(pos), _mm512_setr_epi64(2,4,6,8,10,12,14,16)); \
+  __m512i acc0 = _mm512_setzero_si512(); \
+  __m512i acc1 = _mm512_setzero_si512(); \
+  __m512i acc2 = _mm512_setzero_si512(); \
+  __m512i acc3 = _mm512_setzero_si512(); \
+ \
+  uint32_t i = 0; \
+ \
+  for (; i + 32 <= len; i += 32) { \
+    __m512i v0 = _mm512_loadu_si512((const void *)(msg + 4*i)); \
+    __m512i v1 = _mm512_loadu_si512((const void *)(msg + 4*i + 64)); \
+    acc0 = MADD_EVEN(acc0, v0, w_even); \
+    acc1 = MADD_ODD(acc1, v0, w_odd); \
+    w_even = _mm512_add_epi64(w_even, step); \
+    w_odd = _mm512_add_epi64(w_odd, step); \
+    acc2 = MADD_EVEN(acc2, v1, w_even); \
+    acc3 = MADD_ODD(acc3, v1, w_odd); \
+    w_even = _mm512_add_epi64(w_even, step); \
+    w_odd = _mm512_add_epi64(w_odd, step); \
+  } \
+ \
+  for (; i < len; i += 16) { /* tail: masked load of the last 1..31 words */ \
+    uint32_t rest = len - i; \
+    __mmask16 m = (rest >= 16) ? (__mmask16)0xffff : (__mmask16)((1u << rest) - 1); \
+    __m512i v0 = _mm512_maskz_loadu_epi32(m, (const void *)(msg + 4*i)); \
+    acc0 = MADD_EVEN(acc0, v0, w_even); \
+    acc1 = MADD_ODD(acc1, v0, w_odd); \
+    w_even = _mm512_add_epi64(w_even, step); \
+    w_odd = _mm512_add_epi64(w_odd, step); \
+  } \
+ \
+  acc0 = _mm512_add_epi64(_mm512_add_epi64(acc0, acc1), _mm512_add_epi64(acc2, acc3)); \
+ \
+  return hsum512Epi64(acc0); \
+}
+
+#define MULQ_EVEN(acc, v, w) _mm512_add_epi64(acc, _mm512_mul_epu32(v, w))
+#define MULQ_ODD(acc, v, w) _mm512_add_epi64(acc, _mm512_mul_epu32(_mm512_srli_epi64(v, 32), w))
+#define IFMA_EVEN(acc, v, w) _mm512_madd52lo_epu64(acc, _mm512_and_si512(v, lo32), w)
+#define IFMA_ODD(acc, v, w) _mm512_madd52lo_epu64(acc, _mm512_srli_epi64(v, 32), w)
+
+ADLER_SUM64_AVX512(adlerSum64_avx512, "avx512f", MULQ_EVEN, MULQ_ODD)
+ADLER_SUM64_AVX512(adlerSum64_avx512ifma, "avx512f,avx512ifma", IFMA_EVEN, IFMA_ODD)
+
+#undef MULQ_EVEN
+#undef MULQ_ODD
+#undef IFMA_EVEN
+#undef IFMA_ODD
+
+// cipherXorSum64: the adlerSum64 kernels with every message word XORed with
+// its keystream word first.
+
+GCC_ATTRIB(nothrow,nonnull,pure,target("sse4.1"))
+static uint64_t cipherXorSum64_sse41(const uint8_t * msg, const uint32_t * ks, uint32_t len, uint32_t pos)
+{
+  const __m128i step = _mm_set1_epi64x(4);
+  __m128i w_even = _mm_add_epi64(_mm_set1_epi64x(pos), _mm_set_epi64x(3,1));
+  __m128i w_odd = _mm_add_epi64(_mm_set1_epi64x(pos), _mm_set_epi64x(4,2));
+  __m128i acc0 = _mm_setzero_si128();
+  __m128i acc1 = _mm_setzero_si128();
+
+  uint32_t i = 0;
+
+  for (; i + 4 <= len; i += 4) {
+    __m128i v0 = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(msg + 4*i)), _mm_loadu_si128((const __m128i *)(ks + i)));
+    acc0 = _mm_add_epi64(acc0, _mm_mul_epu32(v0, w_even));
+    acc1 = _mm_add_epi64(acc1, _mm_mul_epu32(_mm_srli_epi64(v0, 32), w_odd));
+    w_even = _mm_add_epi64(w_even, step);
+    w_odd = _mm_add_epi64(w_odd, step);
+  }
+
+  __m128i x = _mm_add_epi64(acc0, acc1);
+  uint64_t adler_sum = hsum128Epi64(x);
+
+  for (; i < len; ++i) { // tail: less than 4 words
+    adler_sum += (uint64_t)(pos+i+1) * (uint64_t)(load32(msg + 4*i) ^ ks[i]);
+  }
+
+  return adler_sum;
+}
+
+GCC_ATTRIB(nothrow,nonnull,pure,target("avx2"))
+static uint64_t cipherXorSum64_avx2(const uint8_t * msg, const uint32_t * ks, uint32_t len, uint32_t pos)
+{
+  const __m256i step = _mm256_set1_epi64x(8);
+  __m256i w_even = _mm256_add_epi64(_mm256_set1_epi64x(pos), _mm256_setr_epi64x(1,3,5,7));
+  __m256i w_odd = _mm256_add_epi64(_mm256_set1_epi64x(pos), _mm256_setr_epi64x(2,4,6,8));
+  __m256i acc0 = _mm256_setzero_si256();
+  __m256i acc1 = _mm256_setzero_si256();
+  __m256i acc2 = _mm256_setzero_si256();
+  __m256i acc3 = _mm256_setzero_si256();
+
+  uint32_t i = 0;
+
+  for (; i + 16 <= len; i += 16) {
+    __m256i v0 = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)(msg + 4*i)),
+      _mm256_loadu_si256((const __m256i *)(ks + i)));
+    __m256i v1 = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)(msg + 4*i + 32)),
+      _mm256_loadu_si256((const __m256i *)(ks + i + 8)));
+    acc0 = _mm256_add_epi64(acc0, _mm256_mul_epu32(v0, w_even));
+    acc1 = _mm256_add_epi64(acc1, _mm256_mul_epu32(_mm256_srli_epi64(v0, 32), w_odd));
+    w_even = _mm256_add_epi64(w_even, step);
+    w_odd = _mm256_add_epi64(w_odd, step);
+    acc2 = _mm256_add_epi64(acc2, _mm256_mul_epu32(v1, w_even));
+    acc3 = _mm256_add_epi64(acc3, _mm256_mul_epu32(_mm256_srli_epi64(v1, 32), w_odd));
+    w_even = _mm256_add_epi64(w_even, step);
+    w_odd = _mm256_add_epi64(w_odd, step);
+  }
+
+  __m256i acc = _mm256_add_epi64(_mm256_add_epi64(acc0, acc1), _mm256_add_epi64(acc2, acc3));
+  __m128i x = _mm_add_epi64(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+  uint64_t adler_sum = hsum128Epi64(x);
+
+  for (; i < len; ++i) { // tail: less than 16 words
+    adler_sum += (uint64_t)(pos+i+1) * (uint64_t)(load32(msg + 4*i) ^ ks[i]);
+  }
+
+  return adler_sum;
+}
+
+GCC_ATTRIB(nothrow,nonnull,pure,target("avx512f"))
+static uint64_t cipherXorSum64_avx512(const uint8_t * msg, const uint32_t * ks, uint32_t len, uint32_t pos)
+{
+  const __m512i step = _mm512_set1_epi64(16);
+  __m512i w_even = _mm512_add_epi64(_mm512_set1_epi64(pos), _mm512_setr_epi64(1,3,5,7,9,11,13,15));
+  __m512i w_odd = _mm512_add_epi64(_mm512_set1_epi64(pos), _mm512_setr_epi64(2,4,6,8,10,12,14,16));
+  __m512i acc0 = _mm512_setzero_si512();
+  __m512i acc1 = _mm512_setzero_si512();
+
+  for (uint32_t i = 0; i < len; i += 16) { // the last 1..16 words with a masked load
+    uint32_t rest = len - i;
+    __mmask16 m = (rest >= 16) ? (__mmask16)0xffff : (__mmask16)((1u << rest) - 1);
+    __m512i v0 = _mm512_xor_si512(_mm512_maskz_loadu_epi32(m, (const void *)(msg + 4*i)),
+      _mm512_maskz_loadu_epi32(m, (const void *)(ks + i)));
+    acc0 = _mm512_add_epi64(acc0, _mm512_mul_epu32(v0, w_even));
+    acc1 = _mm512_add_epi64(acc1, _mm512_mul_epu32(_mm512_srli_epi64(v0, 32), w_odd));
+    w_even = _mm512_add_epi64(w_even, step);
+    w_odd = _mm512_add_epi64(w_odd, step);
+  }
+
+  return hsum512Epi64(_mm512_add_epi64(acc0, acc1));
+}
+
+// cipherXorCrypt64: the cipherXorSum64 kernels plus the store of the XOR
+// with the other keystream.
+
+GCC_ATTRIB(nothrow,nonnull,target("sse4.1"))
+static uint64_t cipherXorCrypt64_sse41(const uint8_t * in, uint8_t * out, const uint32_t * ks_out,
+    const uint32_t * ks_sum, uint32_t len, uint32_t pos)
+{
+  const __m128i step = _mm_set1_epi64x(4);
+  __m128i w_even = _mm_add_epi64(_mm_set1_epi64x(pos), _mm_set_epi64x(3,1));
+  __m128i w_odd = _mm_add_epi64(_mm_set1_epi64x(pos), _mm_set_epi64x(4,2));
+  __m128i acc0 = _mm_setzero_si128();
+  __m128i acc1 = _mm_setzero_si128();
+
+  uint32_t i = 0;
+
+  for (; i + 4 <= len; i += 4) {
+    __m128i w = _mm_loadu_si128((const __m128i *)(in + 4*i));
+    _mm_storeu_si128((__m128i *)(out + 4*i), _mm_xor_si128(w, _mm_loadu_si128((const __m128i *)(ks_out + i))));
+    __m128i v0 = _mm_xor_si128(w, _mm_loadu_si128((const __m128i *)(ks_sum + i)));
+    acc0 = _mm_add_epi64(acc0, _mm_mul_epu32(v0, w_even));
+    acc1 = _mm_add_epi64(acc1, _mm_mul_epu32(_mm_srli_epi64(v0, 32), w_odd));
+    w_even = _mm_add_epi64(w_even, step);
+    w_odd = _mm_add_epi64(w_odd, step);
+  }
+
+  __m128i x = _mm_add_epi64(acc0, acc1);
+  uint64_t adler_sum = hsum128Epi64(x);
+
+  return adler_sum + cipherXorCrypt64_scalar(in + 4*i, out + 4*i, ks_out + i, ks_sum + i, len - i, pos + i);
+}
+
+GCC_ATTRIB(nothrow,nonnull,target("avx2"))
+static uint64_t cipherXorCrypt64_avx2(const uint8_t * in, uint8_t * out, const uint32_t * ks_out,
+    const uint32_t * ks_sum, uint32_t len, uint32_t pos)
+{
+  const __m256i step = _mm256_set1_epi64x(8);
+  __m256i w_even = _mm256_add_epi64(_mm256_set1_epi64x(pos), _mm256_setr_epi64x(1,3,5,7));
+  __m256i w_odd = _mm256_add_epi64(_mm256_set1_epi64x(pos), _mm256_setr_epi64x(2,4,6,8));
+  __m256i acc0 = _mm256_setzero_si256();
+  __m256i acc1 = _mm256_setzero_si256();
+  __m256i acc2 = _mm256_setzero_si256();
+  __m256i acc3 = _mm256_setzero_si256();
+
+  uint32_t i = 0;
+
+  for (; i + 16 <= len; i += 16) {
+    __m256i w0 = _mm256_loadu_si256((const __m256i *)(in + 4*i));
+    __m256i w1 = _mm256_loadu_si256((const __m256i *)(in + 4*i + 32));
+    _mm256_storeu_si256((__m256i *)(out + 4*i), _mm256_xor_si256(w0, _mm256_loadu_si256((const __m256i *)(ks_out + i))));
+    _mm256_storeu_si256((__m256i *)(out + 4*i + 32), _mm256_xor_si256(w1, _mm256_loadu_si256((const __m256i *)(ks_out + i + 8))));
+    __m256i v0 = _mm256_xor_si256(w0, _mm256_loadu_si256((const __m256i *)(ks_sum + i)));
+    __m256i v1 = _mm256_xor_si256(w1, _mm256_loadu_si256((const __m256i *)(ks_sum + i + 8)));
+    acc0 = _mm256_add_epi64(acc0, _mm256_mul_epu32(v0, w_even));
+    acc1 = _mm256_add_epi64(acc1, _mm256_mul_epu32(_mm256_srli_epi64(v0, 32), w_odd));
+    w_even = _mm256_add_epi64(w_even, step);
+    w_odd = _mm256_add_epi64(w_odd, step);
+    acc2 = _mm256_add_epi64(acc2, _mm256_mul_epu32(v1, w_even));
+    acc3 = _mm256_add_epi64(acc3, _mm256_mul_epu32(_mm256_srli_epi64(v1, 32), w_odd));
+    w_even = _mm256_add_epi64(w_even, step);
+    w_odd = _mm256_add_epi64(w_odd, step);
+  }
+
+  __m256i acc = _mm256_add_epi64(_mm256_add_epi64(acc0, acc1), _mm256_add_epi64(acc2, acc3));
+  __m128i x = _mm_add_epi64(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+  uint64_t adler_sum = hsum128Epi64(x);
+
+  return adler_sum + cipherXorCrypt64_scalar(in + 4*i, out + 4*i, ks_out + i, ks_sum + i, len - i, pos + i);
+}
+
+GCC_ATTRIB(nothrow,nonnull,target("avx512f"))
+static uint64_t cipherXorCrypt64_avx512(const uint8_t * in, uint8_t * out, const uint32_t * ks_out,
+    const uint32_t * ks_sum, uint32_t len, uint32_t pos)
+{
+  const __m512i step = _mm512_set1_epi64(16);
+  __m512i w_even = _mm512_add_epi64(_mm512_set1_epi64(pos), _mm512_setr_epi64(1,3,5,7,9,11,13,15));
+  __m512i w_odd = _mm512_add_epi64(_mm512_set1_epi64(pos), _mm512_setr_epi64(2,4,6,8,10,12,14,16));
+  __m512i acc0 = _mm512_setzero_si512();
+  __m512i acc1 = _mm512_setzero_si512();
+
+  for (uint32_t i = 0; i < len; i += 16) { // the last 1..16 words with a masked load and store
+    uint32_t rest = len - i;
+    __mmask16 m = (rest >= 16) ? (__mmask16)0xffff : (__mmask16)((1u << rest) - 1);
+    __m512i w = _mm512_maskz_loadu_epi32(m, (const void *)(in + 4*i));
+    _mm512_mask_storeu_epi32((void *)(out + 4*i), m, _mm512_xor_si512(w, _mm512_maskz_loadu_epi32(m, (const void *)(ks_out + i))));
+    __m512i v0 = _mm512_xor_si512(w, _mm512_maskz_loadu_epi32(m, (const void *)(ks_sum + i)));
+    acc0 = _mm512_add_epi64(acc0, _mm512_mul_epu32(v0, w_even));
+    acc1 = _mm512_add_epi64(acc1, _mm512_mul_epu32(_mm512_srli_epi64(v0, 32), w_odd));
+    w_even = _mm512_add_epi64(w_even, step);
+    w_odd = _mm512_add_epi64(w_odd, step);
+  }
+
+  return hsum512Epi64(_mm512_add_epi64(acc0, acc1));
+}
+
+// copy-and-hash: the sum kernels plus the store of every loaded vector.
+// The stream stores need out aligned to the vector size, and the offsets
+// within a call stay aligned: 32 (AVX2) or 64 (AVX-512) byte steps.
+
+#define ADLER_STORE_AVX2(p, v, nt) \
+  do { \
+    if (nt) _mm256_stream_si256((__m256i *)(p), (v)); \
+    else _mm256_storeu_si256((__m256i *)(p), (v)); \
+  } while (0)
+
+#define ADLER_STORE_AVX512(p, v, nt) \
+  do { \
+    if (nt) _mm512_stream_si512((void *)(p), (v)); \
+    else _mm512_storeu_si512((void *)(p), (v)); \
+  } while (0)
+
+GCC_ATTRIB(nothrow,nonnull,target("avx2"))
+static uint32_t adlerCopySum32_avx2(const uint8_t * in, uint8_t * out, uint32_t len, uint32_t pos, int nt)
+{
+  const __m256i bias = _mm256_set1_epi16((short)0x8000);
+  const __m256i step = _mm256_set1_epi16(16);
+  __m256i w = _mm256_add_epi16(_mm256_set1_epi16((short)pos),
+    _mm256_setr_epi16(1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,16));
+  __m256i acc0 = _mm256_setzero_si256();
+  __m256i acc1 = _mm256_setzero_si256();
+
+  nt = nt && !((uintptr_t)out & 31);
+
+  uint32_t i = 0;
+
+  for (; i + 32 <= len; i += 32) {
+    __m256i x0 = _mm256_loadu_si256((const __m256i *)(in + 2*i));
+    __m256i x1 = _mm256_loadu_si256((const __m256i *)(in + 2*i + 32));
+    ADLER_STORE_AVX2(out + 2*i, x0, nt);
+    ADLER_STORE_AVX2(out + 2*i + 32, x1, nt);
+    acc0 = _mm256_add_epi32(acc0, _mm256_madd_epi16(_mm256_xor_si256(x0, bias), w));
+    w = _mm256_add_epi16(w, step);
+    acc1 = _mm256_add_epi32(acc1, _mm256_madd_epi16(_mm256_xor_si256(x1, bias), w));
+    w = _mm256_add_epi16(w, step);
+  }
+
+  __m256i acc = _mm256_add_epi32(acc0, acc1);
+  __m128i x = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+  x = _mm_add_epi32(x, _mm_shuffle_epi32(x, _MM_SHUFFLE(1,0,3,2)));
+  x = _mm_add_epi32(x, _mm_shuffle_epi32(x, _MM_SHUFFLE(2,3,0,1)));
+
+  uint32_t adler_sum = (uint32_t)_mm_cvtsi128_si32(x);
+  adler_sum += UINT32_C(0x8000) * (i * pos + i * (i + 1) / 2); // remove the bias
+
+  return adler_sum + adlerCopySum32_scalar(in + 2*i, out + 2*i, len - i, pos + i, 0);
+}
+
+GCC_ATTRIB(nothrow,nonnull,target("avx2"))
+static uint64_t adlerCopySum64_avx2(const uint8_t * in, uint8_t * out, uint32_t len, uint32_t pos, int nt)
+{
+  const __m256i step = _mm256_set1_epi64x(8);
+  __m256i w_even = _mm256_add_epi64(_mm256_set1_epi64x(pos), _mm256_setr_epi64x(1,3,5,7));
+  __m256i w_odd = _mm256_add_epi64(_mm256_set1_epi64x(pos), _mm256_setr_epi64x(2,4,6,8));
+  __m256i acc0 = _mm256_setzero_si256();
+  __m256i acc1 = _mm256_setzero_si256();
+  __m256i acc2 = _mm256_setzero_si256();
+  __m256i acc3 = _mm256_setzero_si256();
+
+  nt = nt && !((uintptr_t)out & 31);
+
+  uint32_t i = 0;
+
+  for (; i + 16 <= len; i += 16) {
+    __m256i v0 = _mm256_loadu_si256((const __m256i *)(in + 4*i));
+    __m256i v1 = _mm256_loadu_si256((const __m256i *)(in + 4*i + 32));
+    ADLER_STORE_AVX2(out + 4*i, v0, nt);
+    ADLER_STORE_AVX2(out + 4*i + 32, v1, nt);
+    acc0 = _mm256_add_epi64(acc0, _mm256_mul_epu32(v0, w_even));
+    acc1 = _mm256_add_epi64(acc1, _mm256_mul_epu32(_mm256_srli_epi64(v0, 32), w_odd));
+    w_even = _mm256_add_epi64(w_even, step);
+    w_odd = _mm256_add_epi64(w_odd, step);
+    acc2 = _mm256_add_epi64(acc2, _mm256_mul_epu32(v1, w_even));
+    acc3 = _mm256_add_epi64(acc3, _mm256_mul_epu32(_mm256_srli_epi64(v1, 32), w_odd));
+    w_even = _mm256_add_epi64(w_even, step);
+    w_odd = _mm256_add_epi64(w_odd, step);
+  }
+
+  __m256i acc = _mm256_add_epi64(_mm256_add_epi64(acc0, acc1), _mm256_add_epi64(acc2, acc3));
+  __m128i x = _mm_add_epi64(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+
+  return hsum128Epi64(x) + adlerCopySum64_scalar(in + 4*i, out + 4*i, len - i, pos + i, 0);
+}
+
+GCC_ATTRIB(nothrow,nonnull,target("avx2"))
+static uint64_t cipherCopySum64_avx2(const uint8_t * in, uint8_t * out, const uint32_t * ks,
+    uint32_t len, uint32_t pos, int nt)
+{
+  const __m256i step = _mm256_set1_epi64x(8);
+  __m256i w_even = _mm256_add_epi64(_mm256_set1_epi64x(pos), _mm256_setr_epi64x(1,3,5,7));
+  __m256i w_odd = _mm256_add_epi64(_mm256_set1_epi64x(pos), _mm256_setr_epi64x(2,4,6,8));
+  __m256i acc0 = _mm256_setzero_si256();
+  __m256i acc1 = _mm256_setzero_si256();
+  __m256i acc2 = _mm256_setzero_si256();
+  __m256i acc3 = _mm256_setzero_si256();
+
+  nt = nt && !((uintptr_t)out & 31);
+
+  uint32_t i = 0;
+
+  for (; i + 16 <= len; i += 16) {
+    __m256i w0 = _mm256_loadu_si256((const __m256i *)(in + 4*i));
+    __m256i w1 = _mm256_loadu_si256((const __m256i *)(in + 4*i + 32));
+    ADLER_STORE_AVX2(out + 4*i, w0, nt);
+    ADLER_STORE_AVX2(out + 4*i + 32, w1, nt);
+    __m256i v0 = _mm256_xor_si256(w0, _mm256_loadu_si256((const __m256i *)(ks + i)));
+    __m256i v1 = _mm256_xor_si256(w1, _mm256_loadu_si256((const __m256i *)(ks + i + 8)));
+    acc0 = _mm256_add_epi64(acc0, _mm256_mul_epu32(v0, w_even));
+    acc1 = _mm256_add_epi64(acc1, _mm256_mul_epu32(_mm256_srli_epi64(v0, 32), w_odd));
+    w_even = _mm256_add_epi64(w_even, step);
+    w_odd = _mm256_add_epi64(w_odd, step);
+    acc2 = _mm256_add_epi64(acc2, _mm256_mul_epu32(v1, w_even));
+    acc3 = _mm256_add_epi64(acc3, _mm256_mul_epu32(_mm256_srli_epi64(v1, 32), w_odd));
+    w_even = _mm256_add_epi64(w_even, step);
+    w_odd = _mm256_add_epi64(w_odd, step);
+  }
+
+  __m256i acc = _mm256_add_epi64(_mm256_add_epi64(acc0, acc1), _mm256_add_epi64(acc2, acc3));
+  __m128i x = _mm_add_epi64(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+
+  return hsum128Epi64(x) + cipherCopySum64_scalar(in + 4*i, out + 4*i, ks + i, len - i, pos + i, 0);
+}
+
+GCC_ATTRIB(nothrow,nonnull,target("avx512f,avx512bw"))
+static uint32_t adlerCopySum32_avx512(const uint8_t * in, uint8_t * out, uint32_t len, uint32_t pos, int nt)
+{
+  const __m512i bias = _mm512_set1_epi16((short)0x8000);
+  const __m512i step = _mm512_set1_epi16(32);
+  __m512i w = _mm512_add_epi16(_mm512_set1_epi16((short)pos),
+    _mm512_set_epi16(32,31,30,29,28,27,26,25,24,23,22,21,20,19,18,17,
+    16,15,14,13,12,11,10,9,8,7,6,5,4,3,2,1));
+  __m512i acc0 = _mm512_setzero_si512();
+
+  nt = nt && !((uintptr_t)out & 63);
+
+  uint32_t i = 0;
+
+  for (; i + 32 <= len; i += 32) {
+    __m512i x0 = _mm512_loadu_si512((const void *)(in + 2*i));
+    ADLER_STORE_AVX512(out + 2*i, x0, nt);
+    acc0 = _mm512_add_epi32(acc0, _mm512_madd_epi16(_mm512_xor_si512(x0, bias), w));
+    w = _mm512_add_epi16(w, step);
+  }
+
+  if (i < len) { // the last 1..31 words, with a masked load and store, and zero weight for the rest
+    __mmask32 m = (__mmask32)((UINT32_C(1) << (len - i)) - 1);
+    __m512i x0 = _mm512_maskz_loadu_epi16(m, (const void *)(in + 2*i));
+    _mm512_mask_storeu_epi16((void *)(out + 2*i), m, x0);
+    acc0 = _mm512_add_epi32(acc0, _mm512_madd_epi16(_mm512_xor_si512(x0, bias), _mm512_maskz_mov_epi16(m, w)));
+  }
+
+  uint32_t adler_sum = hsum512Epi32(acc0);
+  adler_sum += UINT32_C(0x8000) * (len * pos + len * (len + 1) / 2); // remove the bias
+
+  return adler_sum;
+}
+
+GCC_ATTRIB(nothrow,nonnull,target("avx512f"))
+static uint64_t adlerCopySum64_avx512(const uint8_t * in, uint8_t * out, uint32_t len, uint32_t pos, int nt)
+{
+  const __m512i step = _mm512_set1_epi64(16);
+  __m512i w_even = _mm512_add_epi64(_mm512_set1_epi64(pos), _mm512_setr_epi64(1,3,5,7,9,11,13,15));
+  __m512i w_odd = _mm512_add_epi64(_mm512_set1_epi64(pos), _mm512_setr_epi64(2,4,6,8,10,12,14,16));
+  __m512i acc0 = _mm512_setzero_si512();
+  __m512i acc1 = _mm512_setzero_si512();
+
+  nt = nt && !((uintptr_t)out & 63);
+
+  for (uint32_t i = 0; i < len; i += 16) {
+    uint32_t rest = len - i;
+    __m512i v0;
+    if (rest >= 16) {
+      v0 = _mm512_loadu_si512((const void *)(in + 4*i));
+      ADLER_STORE_AVX512(out + 4*i, v0, nt);
+    } else { // the last 1..15 words, with a masked load and store
+      __mmask16 m = (__mmask16)((1u << rest) - 1);
+      v0 = _mm512_maskz_loadu_epi32(m, (const void *)(in + 4*i));
+      _mm512_mask_storeu_epi32((void *)(out + 4*i), m, v0);
+    }
+    acc0 = _mm512_add_epi64(acc0, _mm512_mul_epu32(v0, w_even));
+    acc1 = _mm512_add_epi64(acc1, _mm512_mul_epu32(_mm512_srli_epi64(v0, 32), w_odd));
+    w_even = _mm512_add_epi64(w_even, step);
+    w_odd = _mm512_add_epi64(w_odd, step);
+  }
+
+  return hsum512Epi64(_mm512_add_epi64(acc0, acc1));
+}
+
+GCC_ATTRIB(nothrow,nonnull,target("avx512f"))
+static uint64_t cipherCopySum64_avx512(const uint8_t * in, uint8_t * out, const uint32_t * ks,
+    uint32_t len, uint32_t pos, int nt)
+{
+  const __m512i step = _mm512_set1_epi64(16);
+  __m512i w_even = _mm512_add_epi64(_mm512_set1_epi64(pos), _mm512_setr_epi64(1,3,5,7,9,11,13,15));
+  __m512i w_odd = _mm512_add_epi64(_mm512_set1_epi64(pos), _mm512_setr_epi64(2,4,6,8,10,12,14,16));
+  __m512i acc0 = _mm512_setzero_si512();
+  __m512i acc1 = _mm512_setzero_si512();
+
+  nt = nt && !((uintptr_t)out & 63);
+
+  for (uint32_t i = 0; i < len; i += 16) {
+    uint32_t rest = len - i;
+    __mmask16 m = (rest >= 16) ? (__mmask16)0xffff : (__mmask16)((1u << rest) - 1);
+    __m512i w;
+    if (rest >= 16) {
+      w = _mm512_loadu_si512((const void *)(in + 4*i));
+      ADLER_STORE_AVX512(out + 4*i, w, nt);
+    } else { // the last 1..15 words, with a masked load and store
+      w = _mm512_maskz_loadu_epi32(m, (const void *)(in + 4*i));
+      _mm512_mask_storeu_epi32((void *)(out + 4*i), m, w);
+    }
+    __m512i v0 = _mm512_xor_si512(w, _mm512_maskz_loadu_epi32(m, (const void *)(ks + i)));
+    acc0 = _mm512_add_epi64(acc0, _mm512_mul_epu32(v0, w_even));
+    acc1 = _mm512_add_epi64(acc1, _mm512_mul_epu32(_mm512_srli_epi64(v0, 32), w_odd));
+    w_even = _mm512_add_epi64(w_even, step);
+    w_odd = _mm512_add_epi64(w_odd, step);
+  }
+
+  return hsum512Epi64(_mm512_add_epi64(acc0, acc1));
+}
+
+#undef ADLER_STORE_AVX2
+#undef ADLER_STORE_AVX512
+
+// The store fence after non-temporal stores, which are weakly ordered.
+
+INLINE void adlerStoreFence(void)
+{
+  _mm_sfence();
+}
+
+/*
+  cipherKeystream8: Xoroshiro128Plus_next() of 8 independent states in 64-bit
+  lanes. AVX2 has no 64-bit rotate, so it is 2 shifts and an OR, and it runs
+  the 8 lanes as 2 interleaved vectors of 4, which also hides the latency of
+  the serial steps. It takes 4 draws at a time and transposes them with
+  unpack + permute2x128 into 4 consecutive draws of each lane. AVX-512 has
+  vprolq, and scatters every draw to its lane's buffer.
+*/
+
+#define XORO128_STEP_AVX2(a0, a1) \
+  do { \
+    a1 = _mm256_xor_si256(a1, a0); \
+    a0 = _mm256_xor_si256(_mm256_or_si256(_mm256_slli_epi64(a0, 55), _mm256_srli_epi64(a0, 9)), \
+      _mm256_xor_si256(a1, _mm256_slli_epi64(a1, 14))); \
+    a1 = _mm256_or_si256(_mm256_slli_epi64(a1, 36), _mm256_srli_epi64(a1, 28)); \
+  } while (0)
+
+// stores draws r[0..3] of lanes l..l+3 to ks[l..l+3] + 2*d
+#define XORO128_STORE4_AVX2(r, ks, l, d) \
+  do { \
+    __m256i t0 = _mm256_unpacklo_epi64(r[0], r[1]); \
+    __m256i t1 = _mm256_unpackhi_epi64(r[0], r[1]); \
+    __m256i t2 = _mm256_unpacklo_epi64(r[2], r[3]); \
+    __m256i t3 = _mm256_unpackhi_epi64(r[2], r[3]); \
+    _mm256_storeu_si256((__m256i *)(ks[(l)+0] + 2*(d)), _mm256_permute2x128_si256(t0, t2, 0x20)); \
+    _mm256_storeu_si256((__m256i *)(ks[(l)+1] + 2*(d)), _mm256_permute2x128_si256(t1, t3, 0x20)); \
+    _mm256_storeu_si256((__m256i *)(ks[(l)+2] + 2*(d)), _mm256_permute2x128_si256(t0, t2, 0x31)); \
+    _mm256_storeu_si256((__m256i *)(ks[(l)+3] + 2*(d)), _mm256_permute2x128_si256(t1, t3, 0x31)); \
+  } while (0)
+
+GCC_ATTRIB(nothrow,nonnull,target("avx2"))
+static void cipherKeystream8_avx2(uint64_t * s0, uint64_t * s1, uint32_t (*ks)[CIPHER_KS_WORDS], uint32_t n_draws)
+{
+  __m256i a0 = _mm256_loadu_si256((const __m256i *)s0);
+  __m256i a1 = _mm256_loadu_si256((const __m256i *)s1);
+  __m256i b0 = _mm256_loadu_si256((const __m256i *)(s0 + 4));
+  __m256i b1 = _mm256_loadu_si256((const __m256i *)(s1 + 4));
+
+  for (uint32_t d = 0; d < n_draws; d += 4) {
+    __m256i ra[4], rb[4];
+    for (int t = 0; t < 4; ++t) {
+      ra[t] = _mm256_add_epi64(a0, a1);
+      rb[t] = _mm256_add_epi64(b0, b1);
+      XORO128_STEP_AVX2(a0, a1);
+      XORO128_STEP_AVX2(b0, b1);
+    }
+    XORO128_STORE4_AVX2(ra, ks, 0, d);
+    XORO128_STORE4_AVX2(rb, ks, 4, d);
+  }
+
+  _mm256_storeu_si256((__m256i *)s0, a0);
+  _mm256_storeu_si256((__m256i *)s1, a1);
+  _mm256_storeu_si256((__m256i *)(s0 + 4), b0);
+  _mm256_storeu_si256((__m256i *)(s1 + 4), b1);
+}
+
+// cipherV2Sum64: the keystream never leaves the registers. The v2 layout
+// needs no transpose: lanes 0-3 mask words 0-7 of a group, and lanes 4-7
+// words 8-15, so that the draws XOR straight into the message vectors,
+// which then go through the cipherXorSum64 multiplies.
+
+GCC_ATTRIB(nothrow,nonnull,target("avx2"))
+static uint64_t cipherV2Sum64_avx2(const uint8_t * msg, uint32_t len, uint32_t pos, uint64_t * s0, uint64_t * s1)
+{
+  const __m256i step = _mm256_set1_epi64x(8);
+  __m256i w_even = _mm256_add_epi64(_mm256_set1_epi64x(pos), _mm256_setr_epi64x(1,3,5,7));
+  __m256i w_odd = _mm256_add_epi64(_mm256_set1_epi64x(pos), _mm256_setr_epi64x(2,4,6,8));
+  __m256i acc0 = _mm256_setzero_si256();
+  __m256i acc1 = _mm256_setzero_si256();
+  __m256i acc2 = _mm256_setzero_si256();
+  __m256i acc3 = _mm256_setzero_si256();
+
+  __m256i a0 = _mm256_loadu_si256((const __m256i *)s0);
+  __m256i a1 = _mm256_loadu_si256((const __m256i *)s1);
+  __m256i b0 = _mm256_loadu_si256((const __m256i *)(s0 + 4));
+  __m256i b1 = _mm256_loadu_si256((const __m256i *)(s1 + 4));
+
+  for (uint32_t i = 0; i < len; i += 16) {
+    __m256i v0 = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)(msg + 4*i)), _mm256_add_epi64(a0, a1));
+    __m256i v1 = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)(msg + 4*i + 32)), _mm256_add_epi64(b0, b1));
+    XORO128_STEP_AVX2(a0, a1);
+    XORO128_STEP_AVX2(b0, b1);
+    acc0 = _mm256_add_epi64(acc0, _mm256_mul_epu32(v0, w_even));
+    acc1 = _mm256_add_epi64(acc1, _mm256_mul_epu32(_mm256_srli_epi64(v0, 32), w_odd));
+    w_even = _mm256_add_epi64(w_even, step);
+    w_odd = _mm256_add_epi64(w_odd, step);
+    acc2 = _mm256_add_epi64(acc2, _mm256_mul_epu32(v1, w_even));
+    acc3 = _mm256_add_epi64(acc3, _mm256_mul_epu32(_mm256_srli_epi64(v1, 32), w_odd));
+    w_even = _mm256_add_epi64(w_even, step);
+    w_odd = _mm256_add_epi64(w_odd, step);
+  }
+
+  _mm256_storeu_si256((__m256i *)s0, a0);
+  _mm256_storeu_si256((__m256i *)s1, a1);
+  _mm256_storeu_si256((__m256i *)(s0 + 4), b0);
+  _mm256_storeu_si256((__m256i *)(s1 + 4), b1);
+
+  __m256i acc = _mm256_add_epi64(_mm256_add_epi64(acc0, acc1), _mm256_add_epi64(acc2, acc3));
+  __m128i x = _mm_add_epi64(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+  return hsum128Epi64(x);
+}
+
+#undef XORO128_STEP_AVX2
+#undef XORO128_STORE4_AVX2
+
+GCC_ATTRIB(nothrow,nonnull,target("avx512f"))
+static void cipherKeystream8_avx512(uint64_t * s0, uint64_t * s1, uint32_t (*ks)[CIPHER_KS_WORDS], uint32_t n_draws)
+{
+  const __m512i one = _mm512_set1_epi64(1);
+  const int64_t row = CIPHER_KS_WORDS/2; // draws per lane buffer
+  __m512i idx = _mm512_setr_epi64(0, row, 2*row, 3*row, 4*row, 5*row, 6*row, 7*row);
+  __m512i a0 = _mm512_loadu_si512((const void *)s0);
+  __m512i a1 = _mm512_loadu_si512((const void *)s1);
+
+  for (uint32_t d = 0; d < n_draws; ++d) {
+    _mm512_i64scatter_epi64((void *)ks, idx, _mm512_add_epi64(a0, a1), 8);
+    idx = _mm512_add_epi64(idx, one);
+    a1 = _mm512_xor_si512(a1, a0);
+    a0 = _mm512_xor_si512(_mm512_rol_epi64(a0, 55), _mm512_xor_si512(a1, _mm512_slli_epi64(a1, 14)));
+    a1 = _mm512_rol_epi64(a1, 36);
+  }
+
+  _mm512_storeu_si512((void *)s0, a0);
+  _mm512_storeu_si512((void *)s1, a1);
+}
+
+GCC_ATTRIB(nothrow,nonnull,target("avx512f"))
+static uint64_t cipherV2Sum64_avx512(const uint8_t * msg, uint32_t len, uint32_t pos, uint64_t * s0, uint64_t * s1)
+{
+  const __m512i step = _mm512_set1_epi64(16);
+  __m512i w_even = _mm512_add_epi64(_mm512_set1_epi64(pos), _mm512_setr_epi64(1,3,5,7,9,11,13,15));
+  __m512i w_odd = _mm512_add_epi64(_mm512_set1_epi64(pos), _mm512_setr_epi64(2,4,6,8,10,12,14,16));
+  __m512i acc0 = _mm512_setzero_si512();
+  __m512i acc1 = _mm512_setzero_si512();
+
+  __m512i a0 = _mm512_loadu_si512((const void *)s0);
+  __m512i a1 = _mm512_loadu_si512((const void *)s1);
+
+  for (uint32_t i = 0; i < len; i += 16) {
+    __m512i v0 = _mm512_xor_si512(_mm512_loadu_si512((const void *)(msg + 4*i)), _mm512_add_epi64(a0, a1));
+    a1 = _mm512_xor_si512(a1, a0);
+    a0 = _mm512_xor_si512(_mm512_rol_epi64(a0, 55), _mm512_xor_si512(a1, _mm512_slli_epi64(a1, 14)));
+    a1 = _mm512_rol_epi64(a1, 36);
+    acc0 = _mm512_add_epi64(acc0, _mm512_mul_epu32(v0, w_even));
+    acc1 = _mm512_add_epi64(acc1, _mm512_mul_epu32(_mm512_srli_epi64(v0, 32), w_odd));
+    w_even = _mm512_add_epi64(w_even, step);
+    w_odd = _mm512_add_epi64(w_odd, step);
+  }
+
+  _mm512_storeu_si512((void *)s0, a0);
+  _mm512_storeu_si512((void *)s1, a1);
+
+  return hsum512Epi64(_mm512_add_epi64(acc0, acc1));
+}
+
+/*
+  chacha8Blocks8: the 8 blocks in 32-bit lanes, word i of every block in
+  vector i, so the rounds are the scalar code with vector ops. The rotates by
+  16 and 8 are byte shuffles. The blocks are transposed back into the
+  keystream order with two 8x8 transposes, of words 0-7 and of words 8-15.
+*/
+
+#define CHACHA_ROTL_AVX2(x, k) _mm256_or_si256(_mm256_slli_epi32(x, k), _mm256_srli_epi32(x, 32 - (k)))
+
+#define CHACHA_QR_AVX2(a, b, c, d) \
+  do { \
+    a = _mm256_add_epi32(a, b); d = _mm256_shuffle_epi8(_mm256_xor_si256(d, a), rot16); \
+    c = _mm256_add_epi32(c, d); b = CHACHA_ROTL_AVX2(_mm256_xor_si256(b, c), 12); \
+    a = _mm256_add_epi32(a, b); d = _mm256_shuffle_epi8(_mm256_xor_si256(d, a), rot8); \
+    c = _mm256_add_epi32(c, d); b = CHACHA_ROTL_AVX2(_mm256_xor_si256(b, c), 7); \
+  } while (0)
+
+GCC_ATTRIB(nothrow,nonnull,target("avx2"))
+static void chacha8Blocks8_avx2(const uint32_t * in, uint32_t * out)
+{
+  const __m256i rot16 = _mm256_setr_epi8(2,3,0,1,6,7,4,5,10,11,8,9,14,15,12,13,
+    2,3,0,1,6,7,4,5,10,11,8,9,14,15,12,13);
+  const __m256i rot8 = _mm256_setr_epi8(3,0,1,2,7,4,5,6,11,8,9,10,15,12,13,14,
+    3,0,1,2,7,4,5,6,11,8,9,10,15,12,13,14);
+  __m256i v[16], x[16];
+
+  for (int i = 0; i < 16; ++i) v[i] = _mm256_set1_epi32((int)in[i]);
+  v[12] = _mm256_add_epi32(v[12], _mm256_setr_epi32(0,1,2,3,4,5,6,7));
+  for (int i = 0; i < 16; ++i) x[i] = v[i];
+
+  for (int r = 0; r < CHACHA_ROUNDS; r += 2) {
+    CHACHA_QR_AVX2(x[0], x[4], x[8], x[12]);
+    CHACHA_QR_AVX2(x[1], x[5], x[9], x[13]);
+    CHACHA_QR_AVX2(x[2], x[6], x[10], x[14]);
+    CHACHA_QR_AVX2(x[3], x[7], x[11], x[15]);
+    CHACHA_QR_AVX2(x[0], x[5], x[10], x[15]);
+    CHACHA_QR_AVX2(x[1], x[6], x[11], x[12]);
+    CHACHA_QR_AVX2(x[2], x[7], x[8], x[13]);
+    CHACHA_QR_AVX2(x[3], x[4], x[9], x[14]);
+  }
+
+  for (int i = 0; i < 16; ++i) x[i] = _mm256_add_epi32(x[i], v[i]);
+
+  for (int h = 0; h < 16; h += 8) { // words h..h+7 of the 8 blocks
+    __m256i t[8], u[8];
+    for (int i = 0; i < 8; i += 2) {
+      t[i] = _mm256_unpacklo_epi32(x[h+i], x[h+i+1]); // blocks 0,1 | 4,5
+      t[i+1] = _mm256_unpackhi_epi32(x[h+i], x[h+i+1]); // blocks 2,3 | 6,7
+    }
+    for (int i = 0; i < 8; i += 4) {
+      u[i] = _mm256_unpacklo_epi64(t[i], t[i+2]); // block 0 | 4
+      u[i+1] = _mm256_unpackhi_epi64(t[i], t[i+2]); // block 1 | 5
+      u[i+2] = _mm256_unpacklo_epi64(t[i+1], t[i+3]); // block 2 | 6
+      u[i+3] = _mm256_unpackhi_epi64(t[i+1], t[i+3]); // block 3 | 7
+    }
+    for (int b = 0; b < 4; ++b) {
+      _mm256_storeu_si256((__m256i *)(out + 16*b + h), _mm256_permute2x128_si256(u[b], u[b+4], 0x20));
+      _mm256_storeu_si256((__m256i *)(out + 16*(b+4) + h), _mm256_permute2x128_si256(u[b], u[b+4], 0x31));
+    }
+  }
+}
+
+#undef CHACHA_ROTL_AVX2
+#undef CHACHA_QR_AVX2
+
+// aesCtr8: the 8 counter blocks are independent, so the aesenc's of a round
+// are issued back to back and hide its latency.
+
+GCC_ATTRIB(nothrow,nonnull,target("aes,sse4.1"))
+static void aesCtr8_aesni(const uint8_t * rk, uint64_t ctr, uint64_t nonce, uint32_t * out)
+{
+  __m128i k[11], b[8];
+
+  for (int r = 0; r < 11; ++r) k[r] = _mm_loadu_si128((const __m128i *)(rk + 16*r));
+
+  for (int i = 0; i < 8; ++i) b[i] = _mm_xor_si128(_mm_set_epi64x((long long)nonce, (long long)(ctr + i)), k[0]);
+  for (int r = 1; r < 10; ++r) {
+    for (int i = 0; i < 8; ++i) b[i] = _mm_aesenc_si128(b[i], k[r]);
+  }
+  for (int i = 0; i < 8; ++i) _mm_storeu_si128((__m128i *)(out + 4*i), _mm_aesenclast_si128(b[i], k[10]));
+}
+
+// With VAES the 8 blocks are 2 vectors of 4, one aesenc per round each.
+
+GCC_ATTRIB(nothrow,nonnull,target("avx512f,vaes"))
+static void aesCtr8_vaes(const uint8_t * rk, uint64_t ctr, uint64_t nonce, uint32_t * out)
+{
+  __m512i k[11];
+
+  for (int r = 0; r < 11; ++r) k[r] = _mm512_broadcast_i32x4(_mm_loadu_si128((const __m128i *)(rk + 16*r)));
+
+  const __m512i c = _mm512_set_epi64((long long)nonce, (long long)(ctr + 3), (long long)nonce, (long long)(ctr + 2),
+    (long long)nonce, (long long)(ctr + 1), (long long)nonce, (long long)ctr);
+  __m512i b0 = _mm512_xor_si512(c, k[0]);
+  __m512i b1 = _mm512_xor_si512(_mm512_add_epi64(c, _mm512_set_epi64(0,4,0,4,0,4,0,4)), k[0]);
+
+  for (int r = 1; r < 10; ++r) {
+    b0 = _mm512_aesenc_epi128(b0, k[r]);
+    b1 = _mm512_aesenc_epi128(b1, k[r]);
+  }
+
+  _mm512_storeu_si512((void *)out, _mm512_aesenclast_epi128(b0, k[10]));
+  _mm512_storeu_si512((void *)(out + 16), _mm512_aesenclast_epi128(b1, k[10]));
+}
+
+GCC_ATTRIB(nothrow,nonnull,pure,target("avx512f,avx512bw"))
+static uint32_t adlerShortSum32_avx512(const uint8_t * msg, uint32_t n_bytes)
+{
+  const __m512i w_even = _mm512_setr_epi32(1,3,5,7,9,11,13,15,17,19,21,23,25,27,29,31);
+  const __m512i w_odd = _mm512_setr_epi32(2,4,6,8,10,12,14,16,18,20,22,24,26,28,30,32);
+
+  __m512i v = _mm512_maskz_loadu_epi8(~UINT64_C(0) >> (64 - n_bytes), (const void *)msg);
+  __m512i acc = _mm512_mullo_epi32(_mm512_and_si512(v, _mm512_set1_epi32(0xffff)), w_even);
+  acc = _mm512_add_epi32(acc, _mm512_mullo_epi32(_mm512_srli_epi32(v, 16), w_odd));
+
+  return hsum512Epi32(acc);
+}
+
+GCC_ATTRIB(nothrow,nonnull,pure,target("avx512f,avx512bw"))
+static uint64_t adlerShortSum64_avx512(const uint8_t * msg, uint32_t n_bytes)
+{
+  const __m512i w_even = _mm512_setr_epi64(1,3,5,7,9,11,13,15);
+  const __m512i w_odd = _mm512_setr_epi64(2,4,6,8,10,12,14,16);
+
+  __m512i v = _mm512_maskz_loadu_epi8(~UINT64_C(0) >> (64 - n_bytes), (const void *)msg);
+  __m512i acc = _mm512_mul_epu32(v, w_even);
+  acc = _mm512_add_epi64(acc, _mm512_mul_epu32(_mm512_srli_epi64(v, 32), w_odd));
+
+  return hsum512Epi64(acc);
+}
+
+/*
+  zlibAdler32: blocks of 32 (SSSE3) or 64 (AVX2) bytes. Within a block,
+  pmaddubsw + pmaddwd with the taps BLOCK..1 give the block's contribution to
+  s2, and psadbw its byte sum, which goes into s1. Every block also adds
+  BLOCK times the s1 before it to s2, and those are accumulated in ps, which
+  is scaled by BLOCK at the end of a run of blocks: s1 before the run times
+  the number of blocks, plus the partial s1 sums. A run is at most ZLIB_NMAX
+  bytes, after which both sums are reduced mod ZLIB_BASE. The tail, less
+  than a block, goes to the scalar kernel.
+*/
+
+GCC_ATTRIB(nothrow,const,target("sse4.1"))
+INLINE uint32_t hsum128Epi32(__m128i x)
+{
+  x = _mm_add_epi32(x, _mm_shuffle_epi32(x, 0x4e));
+  x = _mm_add_epi32(x, _mm_shuffle_epi32(x, 0xb1));
+  return (uint32_t)_mm_cvtsi128_si32(x);
+}
+
+GCC_ATTRIB(nothrow,nonnull,pure,target("ssse3,sse4.1"))
+static uint32_t zlibAdler32_ssse3(uint32_t adler, const uint8_t * msg, size_t n_bytes)
+{
+  const __m128i tap1 = _mm_setr_epi8(32,31,30,29,28,27,26,25,24,23,22,21,20,19,18,17);
+  const __m128i tap2 = _mm_setr_epi8(16,15,14,13,12,11,10,9,8,7,6,5,4,3,2,1);
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i ones = _mm_set1_epi16(1);
+
+  uint32_t s1 = adler & 0xffff;
+  uint32_t s2 = adler >> 16;
+
+  size_t blocks = n_bytes/32;
+  n_bytes &= 31;
+
+  while (blocks) {
+    uint32_t n = (blocks < ZLIB_NMAX/32) ? (uint32_t)blocks : ZLIB_NMAX/32;
+    blocks -= n;
+
+    __m128i v_ps = _mm_setr_epi32((int)(s1 * n), 0, 0, 0);
+    __m128i v_s2 = _mm_setr_epi32((int)s2, 0, 0, 0);
+    __m128i v_s1 = zero;
+
+    do {
+      __m128i b1 = _mm_loadu_si128((const __m128i *)msg);
+      __m128i b2 = _mm_loadu_si128((const __m128i *)(msg + 16));
+      v_ps = _mm_add_epi32(v_ps, v_s1);
+      v_s1 = _mm_add_epi32(v_s1, _mm_add_epi32(_mm_sad_epu8(b1, zero), _mm_sad_epu8(b2, zero)));
+      v_s2 = _mm_add_epi32(v_s2, _mm_madd_epi16(_mm_maddubs_epi16(b1, tap1), ones));
+      v_s2 = _mm_add_epi32(v_s2, _mm_madd_epi16(_mm_maddubs_epi16(b2, tap2), ones));
+      msg += 32;
+    } while (--n);
+
+    v_s2 = _mm_add_epi32(v_s2, _mm_slli_epi32(v_ps, 5));
+    s1 = (s1 + hsum128Epi32(v_s1)) % ZLIB_BASE;
+    s2 = hsum128Epi32(v_s2) % ZLIB_BASE;
+  }
+
+  return zlibAdler32_scalar(s1 | (s2 << 16), msg, n_bytes);
+}
+
+GCC_ATTRIB(nothrow,nonnull,pure,target("avx2"))
+static uint32_t zlibAdler32_avx2(uint32_t adler, const uint8_t * msg, size_t n_bytes)
+{
+  const __m256i tap1 = _mm256_setr_epi8(64,63,62,61,60,59,58,57,56,55,54,53,52,51,50,49,
+    48,47,46,45,44,43,42,41,40,39,38,37,36,35,34,33);
+  const __m256i tap2 = _mm256_setr_epi8(32,31,30,29,28,27,26,25,24,23,22,21,20,19,18,17,
+    16,15,14,13,12,11,10,9,8,7,6,5,4,3,2,1);
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i ones = _mm256_set1_epi16(1);
+
+  uint32_t s1 = adler & 0xffff;
+  uint32_t s2 = adler >> 16;
+
+  size_t blocks = n_bytes/64;
+  n_bytes &= 63;
+
+  while (blocks) {
+    uint32_t n = (blocks < ZLIB_NMAX/64) ? (uint32_t)blocks : ZLIB_NMAX/64;
+    blocks -= n;
+
+    __m256i v_ps = _mm256_setr_epi32((int)(s1 * n), 0, 0, 0, 0, 0, 0, 0);
+    __m256i v_s2 = _mm256_setr_epi32((int)s2, 0, 0, 0, 0, 0, 0, 0);
+    __m256i v_s1 = zero;
+
+    do {
+      __m256i b1 = _mm256_loadu_si256((const __m256i *)msg);
+      __m256i b2 = _mm256_loadu_si256((const __m256i *)(msg + 32));
+      v_ps = _mm256_add_epi32(v_ps, v_s1);
+      v_s1 = _mm256_add_epi32(v_s1, _mm256_add_epi32(_mm256_sad_epu8(b1, zero), _mm256_sad_epu8(b2, zero)));
+      v_s2 = _mm256_add_epi32(v_s2, _mm256_madd_epi16(_mm256_maddubs_epi16(b1, tap1), ones));
+      v_s2 = _mm256_add_epi32(v_s2, _mm256_madd_epi16(_mm256_maddubs_epi16(b2, tap2), ones));
+      msg += 64;
+    } while (--n);
+
+    v_s2 = _mm256_add_epi32(v_s2, _mm256_slli_epi32(v_ps, 6));
+    __m128i x1 = _mm_add_epi32(_mm256_castsi256_si128(v_s1), _mm256_extracti128_si256(v_s1, 1));
+    __m128i x2 = _mm_add_epi32(_mm256_castsi256_si128(v_s2), _mm256_extracti128_si256(v_s2, 1));
+    s1 = (s1 + hsum128Epi32(x1)) % ZLIB_BASE;
+    s2 = hsum128Epi32(x2) % ZLIB_BASE;
+  }
+
+  return zlibAdler32_scalar(s1 | (s2 << 16), msg, n_bytes);
+}
+
+/*
+  adlerMix32: the batch API's chain step for keys of at most one block, i.e.
+  adlerChain32(0, adler_sum, adlerLcgA32(len), 0), across 8 or 16 lanes.
+
+  The Hull-Dobell division is done in float. len(len+1) <= 2^18 + 2^9 is
+  exact, and the ulp of the quotient is < 1/(len(len+1)), so the rounded
+  quotient always truncates to the exact integer quotient. For a full block
+  it yields lcg_a = 1, as adlerLcgA32() does. AVX2 has no variable 16-bit
+  shifts, so the two rotl16's are done with the halves in 32-bit lanes.
+*/
+
+#define ADLER_MIX32(VEC, PFX, SFX) \
+  const VEC one = PFX##_set1_epi32(1), three = PFX##_set1_epi32(3); \
+  const VEC fifteen = PFX##_set1_epi32(15), sixteen = PFX##_set1_epi32(16); \
+  const VEC lo16 = PFX##_set1_epi32(0xffff); \
+  \
+  VEC len = PFX##_loadu_si##SFX((const VEC *)lens); \
+  VEC lcg_a = PFX##_cvttps_epi32(PFX##_div_ps(PFX##_set1_ps((float)(UINT32_C(1) << ADLER32_SHIFT)), \
+    PFX##_cvtepi32_ps(PFX##_mullo_epi32(len, PFX##_add_epi32(len, one))))); \
+  lcg_a = PFX##_sub_epi32(lcg_a, PFX##_and_si##SFX(PFX##_sub_epi32(lcg_a, one), three)); \
+  \
+  VEC h = PFX##_add_epi32(PFX##_set1_epi32(1013904223), \
+    PFX##_mullo_epi32(PFX##_loadu_si##SFX((const VEC *)sums), lcg_a)); /* j = 0: no ~ */ \
+  h = PFX##_xor_si##SFX(h, PFX##_srli_epi32(h, 1)); /* Gray */ \
+  \
+  VEC lo = PFX##_and_si##SFX(h, lo16); \
+  VEC hi = PFX##_srli_epi32(h, 16); \
+  VEC lo_shift = PFX##_and_si##SFX(hi, fifteen); /* (hi + (uint16_t)j) & 0xf */ \
+  VEC hi_shift = PFX##_and_si##SFX(PFX##_add_epi32(lo, lo16), fifteen); /* (lo + (uint16_t)~j) & 0xf */ \
+  hi = PFX##_and_si##SFX(PFX##_or_si##SFX(PFX##_sllv_epi32(hi, hi_shift), \
+    PFX##_srlv_epi32(hi, PFX##_sub_epi32(sixteen, hi_shift))), lo16); \
+  lo = PFX##_and_si##SFX(PFX##_or_si##SFX(PFX##_sllv_epi32(lo, lo_shift), \
+    PFX##_srlv_epi32(lo, PFX##_sub_epi32(sixteen, lo_shift))), lo16); \
+  \
+  PFX##_storeu_si##SFX((VEC *)hash_codes, PFX##_or_si##SFX(lo, PFX##_slli_epi32(hi, 16)));
+
+GCC_ATTRIB(nothrow,nonnull,target("avx2"))
+static void adlerMix32_avx2(const uint32_t sums[16], const uint32_t lens[16], uint32_t hash_codes[16])
+{
+  for (int half = 0; half < 2; ++half, sums += 8, lens += 8, hash_codes += 8) {
+    ADLER_MIX32(__m256i, _mm256, 256)
+  }
+}
+
+GCC_ATTRIB(nothrow,nonnull,target("avx512f"))
+static void adlerMix32_avx512(const uint32_t sums[16], const uint32_t lens[16], uint32_t hash_codes[16])
+{
+  ADLER_MIX32(__m512i, _mm512, 512)
+}
+
+#undef ADLER_MIX32
+
+#else // !AYBERN_X86
+
+INLINE void adlerStoreFence(void)
+{
+}
+
+#endif // AYBERN_X86
+
+/*
+  DISPATCH
+
+  One entry per instruction set level, in increasing order of preference.
+  adlerKernelInit() runs once at load time, before main(), and points
+  adler_kernel at the best entry that the CPU supports. The cipher variant's
+  PRNG is inherently serial, so its kernel is only the masked weighted sum,
+  cipher_xsum64, over a keystream which is generated ahead of it. The batch
+  API runs CIPHER_LANES of those PRNGs side by side with cipher_ks8, and the
+  ChaCha8 and AES-CTR keystreams are generated 8 blocks at a time by
+  chacha8_x8 and adler_aes_ctr8. The v2 cipher format is SIMD-native: its 8
+  lanes are interleaved in the message, so cipher_v2sum64 generates them side
+  by side in registers, fused with the masked weighted sum. The wide hash64
+  formats keep 4 or 8 lane sums with wide_sum64. zlib_adler32 is the legacy,
+  zlib compatible, Adler-32; its 8-bit taps need SSSE3, which every SSE4.1 CPU
+  has. The copy-and-hash kernels, copy_sum32, copy_sum64 and
+  cipher_copy_sum64, are the sum kernels with a store of every loaded vector;
+  the SSE4.1 level uses the scalar ones. AES-NI is not part of any level,
+  since a VM may hide it from a CPU which has AVX2 or AVX-512, and the AES-CTR
+  keystream must not cost the other kernels their best level: see
+  adlerAesCtr8Select(). The "avx512vaes" level is "avx512ifma" plus 512-bit
+  AES, and the other x86 levels use AES-NI if the CPU has it.
+*/
+
+enum {
+  CPU_SSE41 = 1,
+  CPU_AVX2 = 2,
+  CPU_AVX512 = 4, // F + BW
+  CPU_AVX512IFMA = 8,
+  CPU_AESNI = 16,
+  CPU_VAES = 32
+};
+
+typedef struct {
+  const char * name;
+  unsigned cpu_features; // required
+  uint32_t (*sum32)(const uint8_t * msg, uint32_t len, uint32_t pos);
+  uint64_t (*sum64)(const uint8_t * msg, uint32_t len, uint32_t pos);
+  void (*mix32)(const uint32_t sums[16], const uint32_t lens[16], uint32_t hash_codes[16]); // NULL: scalar
+  uint32_t (*short_sum32)(const uint8_t * msg, uint32_t n_bytes);
+  uint64_t (*short_sum64)(const uint8_t * msg, uint32_t n_bytes);
+  uint64_t (*cipher_xsum64)(const uint8_t * msg, const uint32_t * ks, uint32_t len, uint32_t pos);
+  void (*cipher_ks8)(uint64_t * s0, uint64_t * s1, uint32_t (*ks)[CIPHER_KS_WORDS], uint32_t n_draws);
+  void (*chacha8_x8)(const uint32_t * in, uint32_t * out);
+  uint64_t (*cipher_xcrypt64)(const uint8_t * in, uint8_t * out, const uint32_t * ks_out,
+    const uint32_t * ks_sum, uint32_t len, uint32_t pos);
+  uint64_t (*cipher_v2sum64)(const uint8_t * msg, uint32_t len, uint32_t pos, uint64_t * s0, uint64_t * s1);
+  void (*wide_sum64)(const uint8_t * msg, uint32_t n_vecs, uint32_t k, uint64_t * sums);
+  uint32_t (*zlib_adler32)(uint32_t adler, const uint8_t * msg, size_t n_bytes);
+  uint32_t (*copy_sum32)(const uint8_t * in, uint8_t * out, uint32_t len, uint32_t pos, int nt);
+  uint64_t (*copy_sum64)(const uint8_t * in, uint8_t * out, uint32_t len, uint32_t pos, int nt);
+  uint64_t (*cipher_copy_sum64)(const uint8_t * in, uint8_t * out, const uint32_t * ks,
+    uint32_t len, uint32_t pos, int nt);
+} AdlerKernels;
+
+static const AdlerKernels adler_kernels[] = {
+  { "scalar", 0,
+    adlerSum32_scalar, adlerSum64_scalar, NULL,
+    adlerShortSum32_scalar, adlerShortSum64_scalar,
+    cipherXorSum64_scalar, cipherKeystream8_scalar,
+    chacha8Blocks8_scalar,
+    cipherXorCrypt64_scalar, cipherV2Sum64_scalar,
+    adlerWideSum64_scalar,
+    zlibAdler32_scalar,
+    adlerCopySum32_scalar, adlerCopySum64_scalar, cipherCopySum64_scalar },
+#ifdef AYBERN_X86
+  { "sse4.1", CPU_SSE41,
+    adlerSum32_sse41, adlerSum64_sse41, NULL,
+    adlerShortSum32_scalar, adlerShortSum64_scalar,
+    cipherXorSum64_sse41, cipherKeystream8_scalar,
+    chacha8Blocks8_scalar,
+    cipherXorCrypt64_sse41, cipherV2Sum64_scalar,
+    adlerWideSum64_scalar,
+    zlibAdler32_ssse3,
+    adlerCopySum32_scalar, adlerCopySum64_scalar, cipherCopySum64_scalar },
+  { "avx2", CPU_AVX2,
+    adlerSum32_avx2, adlerSum64_avx2, adlerMix32_avx2,
+    adlerShortSum32_scalar, adlerShortSum64_scalar,
+    cipherXorSum64_avx2, cipherKeystream8_avx2,
+    chacha8Blocks8_avx2,
+    cipherXorCrypt64_avx2, cipherV2Sum64_avx2,
+    adlerWideSum64_avx2,
+    zlibAdler32_avx2,
+    adlerCopySum32_avx2, adlerCopySum64_avx2, cipherCopySum64_avx2 },
+  { "avx512", CPU_AVX512,
+    adlerSum32_avx512, adlerSum64_avx512, adlerMix32_avx512,
+    adlerShortSum32_avx512, adlerShortSum64_avx512,
+    cipherXorSum64_avx512, cipherKeystream8_avx512,
+    chacha8Blocks8_avx2,
+    cipherXorCrypt64_avx512, cipherV2Sum64_avx512,
+    adlerWideSum64_avx512,
+    zlibAdler32_avx2,
+    adlerCopySum32_avx512, adlerCopySum64_avx512, cipherCopySum64_avx512 },
+  { "avx512ifma", CPU_AVX512 | CPU_AVX512IFMA,
+    adlerSum32_avx512, adlerSum64_avx512ifma, adlerMix32_avx512,
+    adlerShortSum32_avx512, adlerShortSum64_avx512,
+    cipherXorSum64_avx512, cipherKeystream8_avx512,
+    chacha8Blocks8_avx2,
+    cipherXorCrypt64_avx512, cipherV2Sum64_avx512,
+    adlerWideSum64_avx512,
+    zlibAdler32_avx2,
+    adlerCopySum32_avx512, adlerCopySum64_avx512, cipherCopySum64_avx512 },
+  { "avx512vaes", CPU_AVX512 | CPU_AVX512IFMA | CPU_VAES,
+    adlerSum32_avx512, adlerSum64_avx512ifma, adlerMix32_avx512,
+    adlerShortSum32_avx512, adlerShortSum64_avx512,
+    cipherXorSum64_avx512, cipherKeystream8_avx512,
+    chacha8Blocks8_avx2,
+    cipherXorCrypt64_avx512, cipherV2Sum64_avx512,
+    adlerWideSum64_avx512,
+    zlibAdler32_avx2,
+    adlerCopySum32_avx512, adlerCopySum64_avx512, cipherCopySum64_avx512 },
+#endif
+};
+
+#define N_ADLER_KERNELS (sizeof(adler_kernels)/sizeof(adler_kernels[0]))
+
+static const AdlerKernels * adler_kernel = &adler_kernels[0];
+
+typedef void (*AesCtr8Fn)(const uint8_t * rk, uint64_t ctr, uint64_t nonce, uint32_t * out);
+
+static AesCtr8Fn adler_aes_ctr8 = aesCtr8_scalar;
+
+GCC_ATTRIB(nothrow)
+static unsigned adlerCpuFeatures(void)
+{
+  unsigned features = 0;
+
+#ifdef AYBERN_X86
+  __builtin_cpu_init();
+
+  if (__builtin_cpu_supports("sse4.1")) features |= CPU_SSE41;
+  if (__builtin_cpu_supports("avx2")) features |= CPU_AVX2;
+  if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")) features |= CPU_AVX512;
+  if (__builtin_cpu_supports("avx512ifma")) features |= CPU_AVX512IFMA;
+  if (__builtin_cpu_supports("aes")) features |= CPU_AESNI;
+  if (__builtin_cpu_supports("vaes")) features |= CPU_VAES;
+#endif
+
+  return features;
+}
+
+// The AES-CTR keystream kernel, from the CPU's own AES-NI support rather
+// than the level's. VAES is the one AES path which is a level of its own,
+// "avx512vaes", so that the AES-NI and the VAES paths can both be selected,
+// and the scalar level stays the software reference.
+
+GCC_ATTRIB(nothrow,nonnull)
+static void adlerAesCtr8Select(const AdlerKernels * k, unsigned features)
+{
+  adler_aes_ctr8 = aesCtr8_scalar;
+
+#ifdef AYBERN_X86
+  if (!k->cpu_features) return;
+
+  if (k->cpu_features & CPU_VAES) adler_aes_ctr8 = aesCtr8_vaes;
+  else if (features & CPU_AESNI) adler_aes_ctr8 = aesCtr8_aesni;
+#endif
+}
+
+GCC_ATTRIB(nothrow,constructor)
+static void adlerKernelInit(void)
+{
+  unsigned features = adlerCpuFeatures();
+
+  for (const AdlerKernels * k = adler_kernels; k < adler_kernels + N_ADLER_KERNELS; ++k) {
+    if ((k->cpu_features & features) == k->cpu_features) adler_kernel = k;
+  }
+
+  adlerAesCtr8Select(adler_kernel, features);
+}
+
+GCC_ATTRIB(nothrow,pure)
+const char * AYBern_adlerKernelName(void)
+{
+  return adler_kernel->name;
+}
+
+GCC_ATTRIB(nothrow,nonnull)
+int AYBern_adlerSelectKernel(const char * name)
+{
+  for (const AdlerKernels * k = adler_kernels; k < adler_kernels + N_ADLER_KERNELS; ++k) {
+    if (strcmp(k->name, name) == 0) {
+      unsigned features = adlerCpuFeatures();
+      if ((k->cpu_features & features) != k->cpu_features) return -1;
+      adler_kernel = k;
+      adlerAesCtr8Select(k, features);
+      return 0;
+    }
+  }
+  return -1;
+}
+
+/*
+  BLOCK CHAIN
+
+  Each block's adler_sum depends only on that block's data. What turns the
+  sums into a hash is the cheap, sequential, per-block chaining step below:
+  the lcg bit spread, the order dependent XOR, and the mixer. It is shared by
+  the serial and the parallel entry points so that they cannot drift apart.
+*/
+
+// GOTCHYA: since our block sizes are 2^N by design, when we report that the
+// last_block_len is zero, in fact it means that it is full size,
+// i.e. block_len !
+
+// The Hull-Dobell multipliers of every last_block_len, precomputed since a
+// short key costs less to hash than the division. Index 0 is unused. Entry
+// len is:
+//
+//   lcg_a = 2^SHIFT/(len * (len + 1)), minus ((lcg_a - 1) & 3)
+//
+// which satisfies the Hull-Dobell multiplier constraint lcg_a = 1 mod 4. A
+// full block, len = block_len, has lcg_a = 1. Only the tails of short
+// messages, up to 16 words, are tabulated for hash64.
+
+static const uint32_t adler_lcg_a32[ADLER32_BLOCK_LEN + 1] = {
+  0, 262141, 87381, 43689, 26213, 17473, 12481, 9361,
+  7281, 5825, 4765, 3969, 3357, 2877, 2493, 2181,
+  1925, 1713, 1533, 1377, 1245, 1133, 1033, 949,
+  873, 805, 745, 693, 645, 601, 561, 525,
+  493, 465, 437, 413, 393, 369, 353, 333,
+  317, 301, 289, 277, 261, 253, 241, 229,
+  221, 213, 205, 197, 189, 181, 173, 169,
+  161, 157, 153, 145, 141, 137, 133, 129,
+  125, 121, 117, 113, 109, 105, 105, 101,
+  97, 97, 93, 89, 89, 85, 85, 81,
+  77, 77, 77, 73, 73, 69, 69, 65,
+  65, 65, 61, 61, 61, 57, 57, 57,
+  53, 53, 53, 49, 49, 49, 49, 45,
+  45, 45, 45, 45, 41, 41, 41, 41,
+  41, 37, 37, 37, 37, 37, 37, 33,
+  33, 33, 33, 33, 33, 33, 29, 29,
+  29, 29, 29, 29, 29, 29, 25, 25,
+  25, 25, 25, 25, 25, 25, 25, 25,
+  25, 21, 21, 21, 21, 21, 21, 21,
+  21, 21, 21, 21, 21, 21, 17, 17,
+  17, 17, 17, 17, 17, 17, 17, 17,
+  17, 17, 17, 17, 17, 17, 17, 17,
+  13, 13, 13, 13, 13, 13, 13, 13,
+  13, 13, 13, 13, 13, 13, 13, 13,
+  13, 13, 13, 13, 13, 13, 13, 13,
+  13, 9, 9, 9, 9, 9, 9, 9,
+  9, 9, 9, 9, 9, 9, 9, 9,
+  9, 9, 9, 9, 9, 9, 9, 9,
+  9, 9, 9, 9, 9, 9, 9, 9,
+  9, 9, 9, 9, 9, 9, 9, 9,
+  9, 5, 5, 5, 5, 5, 5, 5,
+  5, 5, 5, 5, 5, 5, 5, 5,
+  5, 5, 5, 5, 5, 5, 5, 5,
+  5, 5, 5, 5, 5, 5, 5, 5,
+  5, 5, 5, 5, 5, 5, 5, 5,
+  5, 5, 5, 5, 5, 5, 5, 5,
+  5, 5, 5, 5, 5, 5, 5, 5,
+  5, 5, 5, 5, 5, 5, 5, 5,
+  5, 5, 5, 5, 5, 5, 5, 5,
+  5, 5, 5, 5, 5, 5, 5, 5,
+  5, 5, 5, 5, 1, 1, 1, 1,
+  1, 1, 1, 1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1, 1, 1, 1,
+  1,
+};
+
+#define ADLER64_LCG_A_TAB 16
+
+static const uint64_t adler_lcg_a64[ADLER64_LCG_A_TAB + 1] = {
+  UINT64_C(0), UINT64_C(17179869181), UINT64_C(5726623061), UINT64_C(2863311529),
+  UINT64_C(1717986917), UINT64_C(1145324609), UINT64_C(818089005), UINT64_C(613566753),
+  UINT64_C(477218585), UINT64_C(381774869), UINT64_C(312361257), UINT64_C(260301045),
+  UINT64_C(220254733), UINT64_C(188789769), UINT64_C(163617801), UINT64_C(143165573),
+  UINT64_C(126322565),
+};
+
+GCC_ATTRIB(nothrow,pure)
+INLINE uint32_t adlerLcgA32(uint32_t len)
+{
+  return adler_lcg_a32[len];
+}
+
+GCC_ATTRIB(nothrow,pure)
+static uint64_t adlerLcgA64(uint32_t len)
+{
+  // all blocks except the last, are by definition full size so their lcg_a = 1
+  if (len == ADLER64_BLOCK_LEN) return 1;
+  if (len <= ADLER64_LCG_A_TAB) return adler_lcg_a64[len];
+
+  uint64_t lcg_a = (UINT64_C(1) << ADLER64_SHIFT)/((uint64_t)len * (len + 1));
+  // satisfy Hull-Dobell multiplier constraint
+  uint64_t hd_remainder = (lcg_a - 1) & 3;
+  if (hd_remainder) lcg_a -= hd_remainder;
+
+  return lcg_a;
+}
+
+GCC_ATTRIB(nothrow,const)
+INLINE uint32_t adlerChain32(uint32_t hash_code, uint32_t adler_sum, uint32_t lcg_a, uint64_t j)
+{
+  const uint32_t lcg_c = 1013904223; // Numerical Recipes lcg32 prime > max(lcg_a)
+
+  // lcg: params selected to evenly spread the bits over the whole 2^32 space
+
+  uint32_t lcg = lcg_c;
+  if (lcg_a == 1) {
+      lcg += adler_sum;
+  } else {
+      lcg += adler_sum * lcg_a; // spread the bits for smaller block sizes
+  }
+
+  // block chain with order dependencies
+
+  hash_code ^= (j & 1) ? ~lcg : lcg; // block order dependency by using j
+
+  // mix: "roll my own" mixer because SplitMix doesn't handle 32 bits
+
+  // 1. Gray xform
+
+  hash_code ^= hash_code >> 1;
+
+  // 2. double Rivest DDR
+
+  uint16_t lo = hash_code & 0xffff;
+  uint16_t hi = hash_code >> 16;
+
+  uint16_t lo_shift = (hi + (uint16_t)j) & 0xf; // block order dependency by using j
+  uint16_t hi_shift = (lo + (uint16_t)~j) & 0xf; // block order dependency by using j
+
+  hi = rotl16(hi, (int16_t)hi_shift);
+  lo = rotl16(lo, (int16_t)lo_shift);
+
+  // put humpty dumpty back together again
+
+  return (uint32_t)lo | ((uint32_t)hi << 16);
+}
+
+GCC_ATTRIB(nothrow,const)
+INLINE uint64_t adlerChain64(uint64_t hash_code, uint64_t adler_sum, uint64_t lcg_a, uint64_t j)
+{
+  const uint64_t lcg_c = UINT64_C(1442695040888963407); // Knuth lcg64. It is not prime
+
+  // lcg: params selected to evenly spread the bits over the whole 2^64 space
+
+  uint64_t lcg = lcg_c;
+  if (lcg_a == UINT64_C(1)) {
+      lcg += adler_sum;
+  } else {
+      lcg += adler_sum * lcg_a; // spread the bits for smaller block sizes
+  }
+
+  // block chain with order dependencies
+
+  hash_code ^= lcg;
+
+  // mix: SplitMix is a fanatastic mixer - without being heavy
+
+  return SplitMix_next(hash_code + j); // block order dependency by using j
+}
+
+/*
+  ONE-SHOT
+
+  The word and the byte ("Mem") entry points share one implementation per
+  hash, which reads the message through a byte pointer with no alignment
+  requirement. A byte message which does not end on a word boundary is
+  padded with zero bytes, i.e. it hashes the same as the zero padded buffer
+  would with the word API. Only the padded tail word is assembled locally,
+  the rest of the message is never copied.
+
+  Lengths are size_t and the block counter j is 64 bits, so there is no limit
+  other than the address space. For any message that the original uint32_t
+  word count could express, the result is unchanged.
+*/
+
+// The block walk of every one-shot hash: the message of n_bytes, as words
+// of word_size bytes including the zero padded tail word, is cut into blocks
+// of block_len words. block_sum is evaluated once per block, in block order,
+// with k (the block's first word), len (its words) and tail (the bytes of
+// the padded tail word in the last block, otherwise 0) in scope, and each
+// sum is chained with its lcg_a: 1 for a full block, and lcg_a_fn(len) for
+// a partial last block. The hash ends up in hash_code, which is 0 for an
+// empty message.
+
+#define ADLER_BLOCK_WALK(hash_t, hash_code, n_bytes, word_size, block_len, lcg_a_fn, chain, block_sum) \
+  do { \
+    const size_t n_ = (n_bytes)/(word_size) + (((n_bytes) & ((word_size)-1)) != 0); \
+    const uint32_t tail_bytes_ = (uint32_t)((n_bytes) & ((word_size)-1)); \
+    const uint32_t last_block_len_ = n_ & ((block_len)-1); \
+    const uint64_t n_blocks_ = n_/(block_len) + (last_block_len_ != 0); \
+    size_t k = 0; \
+    (hash_code) = 0; \
+    for (uint64_t j_ = 0; j_ < n_blocks_; ++j_, k += (block_len)) { /* block loop: begin */ \
+      uint32_t len = (block_len); \
+      uint32_t tail = 0; \
+      hash_t lcg_a = 1; \
+      if (j_ == n_blocks_ - 1) { \
+        if (last_block_len_) { \
+          len = last_block_len_; \
+          lcg_a = lcg_a_fn(len); \
+        } \
+        tail = tail_bytes_; \
+      } /* otherwise it is a full size block */ \
+      hash_t adler_sum_ = (block_sum); \
+      (hash_code) = chain((hash_code), adler_sum_, lcg_a, j_); \
+    } /* block loop: end */ \
+  } while (0)
+
+// The sum of a whole block of len words, the last of which is padded with
+// zeros from tail_bytes bytes when tail_bytes != 0.
+
+GCC_ATTRIB(nothrow,nonnull,pure)
+static uint32_t adlerBlockSum32(const uint8_t * msg, uint32_t len, uint32_t tail_bytes)
+{
+  if (!tail_bytes) return adler_kernel->sum32(msg, len, 0);
+
+  uint32_t whole = len - 1;
+  uint8_t pad[2] = { 0, 0 };
+  memcpy(pad, msg + 2*whole, tail_bytes);
+
+  return adler_kernel->sum32(msg, whole, 0) + adler_kernel->sum32(pad, 1, whole);
+}
+
+GCC_ATTRIB(nothrow,nonnull,pure)
+static uint64_t adlerBlockSum64(const uint8_t * msg, uint32_t len, uint32_t tail_bytes)
+{
+  if (!tail_bytes) return adler_kernel->sum64(msg, len, 0);
+
+  uint32_t whole = len - 1;
+  uint8_t pad[4] = { 0, 0, 0, 0 };
+  memcpy(pad, msg + 4*whole, tail_bytes);
+
+  return adler_kernel->sum64(msg, whole, 0) + adler_kernel->sum64(pad, 1, whole);
+}
+
+// Short messages, 1 to 64 bytes, i.e. up to one cache line, are a single
+// block with j = 0: one short_sum kernel call, a table lookup for lcg_a and
+// one chain step.
+
+GCC_ATTRIB(nothrow,nonnull,pure)
+static uint32_t adlerHash32(const uint8_t * msg, size_t n_bytes)
+{
+  if (n_bytes - 1 < ADLER_SHORT_BYTES) { // 1..64 bytes, wraps around for 0
+    return adlerChain32(0, adler_kernel->short_sum32(msg, (uint32_t)n_bytes), adler_lcg_a32[(n_bytes + 1)/2], 0);
+  }
+
+  uint32_t hash_code;
+
+  // retain original adler32 speed and simplicity
+  ADLER_BLOCK_WALK(uint32_t, hash_code, n_bytes, 2, ADLER32_BLOCK_LEN, adlerLcgA32, adlerChain32,
+    adlerBlockSum32(msg + 2*k, len, tail));
+
+  return hash_code;
+}
+
+GCC_ATTRIB(nothrow,nonnull,pure)
+static uint64_t adlerHash64(const uint8_t * msg, size_t n_bytes)
+{
+  if (n_bytes - 1 < ADLER_SHORT_BYTES) { // 1..64 bytes, wraps around for 0
+    return adlerChain64(0, adler_kernel->short_sum64(msg, (uint32_t)n_bytes), adler_lcg_a64[(n_bytes + 3)/4], 0);
+  }
+
+  uint64_t hash_code;
+
+  ADLER_BLOCK_WALK(uint64_t, hash_code, n_bytes, 4, ADLER64_BLOCK_LEN, adlerLcgA64, adlerChain64,
+    adlerBlockSum64(msg + 4*k, len, tail));
+
+  return hash_code;
+}
+
+/*
+  The wide hash64 formats, x4 and x8: k interleaved lanes, lane l being
+  words l, l+k, l+2k, ... and every lane is summed the way adlerHash64()
+  sums a block, i.e. with its own lane local weights. A block is k *
+  ADLER64_BLOCK_LEN words, so that a lane of a full block is exactly a full
+  hash64 block, and keeps the README bit spread: a full lane wraps its sum
+  about once, and a short lane gets the Hull-Dobell lcg_a of its own length.
+  At the end of a block every non empty lane is folded into the block chain
+  in lane order, as chain step k*j + l. The k independent sums have no
+  serial dependency between adjacent words, and the wide_sum64 kernels need
+  no multiplies. These are new digest formats, unrelated to adlerHash64(),
+  and x4 and x8 only coincide on messages of at most 4 words.
+*/
+
+GCC_ATTRIB(nothrow,nonnull,pure)
+static uint64_t adlerHash64Wide(const uint8_t * msg, size_t n_bytes, uint32_t k)
+{
+  uint64_t hash_code = 0;
+
+  const uint32_t block_len = k * ADLER64_BLOCK_LEN;
+
+  size_t n = n_bytes/4 + ((n_bytes & 3) != 0); // including the padded tail word
+  uint32_t tail_bytes = n_bytes & 3;
+
+  uint32_t len = block_len;
+  uint64_t n_blocks = n/block_len;
+  uint32_t last_block_len = n % block_len;
+  if (last_block_len) ++n_blocks;
+
+  uint64_t j;
+  size_t k_word;
+
+  for (j=0, k_word=0; j < n_blocks; ++j, k_word+=block_len) { // block loop: begin
+
+    const uint8_t * p = msg + 4*k_word;
+    uint32_t tail = 0;
+
+    if (j == (n_blocks - 1)) {
+      if (last_block_len) len = last_block_len;
+      tail = tail_bytes;
+    }
+
+    uint64_t sums[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+    uint32_t whole = (tail) ? len - 1 : len; // words read straight from msg
+    uint32_t n_vecs = whole/16;
+
+    adler_kernel->wide_sum64(p, n_vecs, k, sums);
+
+    for (uint32_t i = 16*n_vecs; i < len; ++i) { // the last 0..15 words, with the padded tail word
+      uint8_t pad[4] = { 0, 0, 0, 0 };
+      memcpy(pad, p + 4*i, (i < whole) ? 4 : tail);
+      sums[i & (k-1)] += (uint64_t)(i/k + 1) * (uint64_t)load32(pad);
+    }
+
+    for (uint32_t l = 0; l < k && l < len; ++l) {
+      uint32_t lane_len = (len - l + k - 1)/k;
+      hash_code = adlerChain64(hash_code, sums[l], adlerLcgA64(lane_len), k*j + l);
+    }
+  } // block loop: end
+
+  return hash_code;
+}
+
+/*
+  The native 32-bit cipher variant: the 16-bit words and the 1K byte blocks
+  of adlerHash32(), masked by Xoroshiro64**, whose every 32-bit draw masks
+  an (even, odd) pair of words: the low half the even word and the high half
+  the odd one, which is arithmetic and so the same in any byte order. Like
+  the 64-bit variant, every block starts with a fresh draw. The PRNG is
+  stepped inline in the sum, since on a 32-bit target without SIMD a
+  keystream buffer would only add loads and stores, and all the arithmetic
+  in the loop is 32 bits.
+*/
+
+GCC_ATTRIB(nothrow,nonnull)
+static uint32_t cipherBlockSum32(const uint8_t * msg, uint32_t len, uint32_t tail_bytes, uint32_t s[2])
+{
+  uint32_t adler_sum = 0;
+  uint32_t whole = (tail_bytes) ? len - 1 : len; // words read straight from msg
+  uint32_t i;
+
+  for (i = 0; i + 2 <= whole; i += 2) {
+    uint32_t r32 = Xoroshiro64StarStar_next(s);
+    adler_sum += (i+1) * (uint32_t)(load16(msg + 2*i) ^ (r32 & 0xffff));
+    adler_sum += (i+2) * (uint32_t)(load16(msg + 2*i + 2) ^ (r32 >> 16));
+  }
+
+  if (i < len) { // the last 1 or 2 words, with the padded tail word
+    uint8_t pad[4] = { 0, 0, 0, 0 };
+    memcpy(pad, msg + 2*i, 2*(whole - i) + tail_bytes);
+    uint32_t r32 = Xoroshiro64StarStar_next(s);
+    adler_sum += (i+1) * (uint32_t)(load16(pad) ^ (r32 & 0xffff));
+    if (i + 1 < len) adler_sum += (i+2) * (uint32_t)(load16(pad + 2) ^ (r32 >> 16));
+  }
+
+  return adler_sum;
+}
+
+GCC_ATTRIB(nothrow,nonnull,pure)
+static uint32_t cipherHash32(const uint8_t * msg, size_t n_bytes, const uint32_t iv[2], uint32_t seed)
+{
+  uint32_t hash_code;
+
+  // temper the iv
+  uint32_t s[2] = { SplitMix32_next(iv[0]^seed), SplitMix32_next(iv[1]) };
+
+  ADLER_BLOCK_WALK(uint32_t, hash_code, n_bytes, 2, ADLER32_BLOCK_LEN, adlerLcgA32, adlerChain32,
+    cipherBlockSum32(msg + 2*k, len, tail, s));
+
+  return hash_code;
+}
+
+/*
+  The cipher variant as a policy: CIPHER_HASH_FUNCS(G) instantiates the
+  one-shot cipher hash for the keystream generator G (see KEYSTREAM
+  GENERATORS), whose fill is inlined into the block loop. The keystream is
+  generated CIPHER_KS_WORDS words at a time into a buffer which stays in L1,
+  and the cipher_xsum64 kernel consumes it. A whole block is a whole number
+  of buffers, so every block starts with a fresh fill, and only the last
+  fill of a message is short. It defines:
+
+    cipherSum_G(msg, len, pos, st, tail_bytes): the cipher sum of len words
+      from word pos of a block, with the generator state st, which ends up
+      after the fills of the len words. With tail_bytes, the last word is
+      the message's padded tail word, and only tail_bytes of it are read.
+      pos must be where a fill starts: even for the 64-bit generators,
+      whose every draw masks an (even, odd) pair of words, and 0 for the
+      block ciphers.
+    cipherHashState_G(msg, n_bytes, tempered): from a tempered state
+    cipherHash_G(msg, n_bytes, iv, seed)
+
+  Every cipher sum of the original variant, one-shot, streaming, parallel
+  and batch, goes through cipherSum_Xoroshiro128Plus(), so that the
+  keystream and the tail padding have a single implementation.
+*/
+
+#define CIPHER_HASH_FUNCS(G) \
+GCC_ATTRIB(nothrow,nonnull) \
+static uint64_t cipherSum_##G(const uint8_t * msg, uint32_t len, uint32_t pos, G##_State * st, \
+    uint32_t tail_bytes) \
+{ \
+  uint32_t ks[CIPHER_KS_WORDS]; \
+  uint64_t adler_sum = 0; \
+ \
+  for (uint32_t i = 0; i < len; i += CIPHER_KS_WORDS) { \
+    uint32_t m = (len - i < CIPHER_KS_WORDS) ? len - i : CIPHER_KS_WORDS; \
+    const uint8_t * p = msg + 4*i; \
+    G##_fill(st, ks, m); \
+    if (tail_bytes && i + m == len) { /* the padded tail word */ \
+      uint8_t pad[4] = { 0, 0, 0, 0 }; \
+      memcpy(pad, p + 4*(m - 1), tail_bytes); \
+      adler_sum += adler_kernel->cipher_xsum64(p, ks, m - 1, pos + i); \
+      adler_sum += adler_kernel->cipher_xsum64(pad, ks + m - 1, 1, pos + i + m - 1); \
+    } else { \
+      adler_sum += adler_kernel->cipher_xsum64(p, ks, m, pos + i); \
+    } \
+  } \
+ \
+  return adler_sum; \
+} \
+ \
+GCC_ATTRIB(nothrow,nonnull,pure) \
+static uint64_t cipherHashState_##G(const uint8_t * msg, size_t n_bytes, const G##_State * tempered) \
+{ \
+  uint64_t hash_code; \
+  G##_State st = *tempered; \
+ \
+  ADLER_BLOCK_WALK(uint64_t, hash_code, n_bytes, 4, ADLER64_BLOCK_LEN, adlerLcgA64, adlerChain64, \
+    cipherSum_##G(msg + 4*k, len, 0, &st, tail)); \
+ \
+  return hash_code; \
+} \
+ \
+GCC_ATTRIB(nothrow,nonnull,pure) \
+static uint64_t cipherHash_##G(const uint8_t * msg, size_t n_bytes, const uint64_t iv[2], uint64_t seed) \
+{ \
+  G##_State st; \
+  G##_seed(&st, iv, seed); \
+ \
+  return cipherHashState_##G(msg, n_bytes, &st); \
+}
+
+// ChaCha8 is the one keystream with cryptographic strength. Its state is the
+// ChaCha input block, keyed with 4 tempered words and a zero nonce, and it is
+// generated 8 blocks, 128 words, at a time by the chacha8_x8 kernel.
+
+typedef struct {
+  uint32_t in[16];
+} ChaCha8_State;
+
+GCC_ATTRIB(nothrow,nonnull)
+INLINE void ChaCha8_seed(ChaCha8_State * st, const uint64_t iv[2], uint64_t seed)
+{
+  uint64_t key[4];
+  cipherTemper64(key, 4, iv, seed);
+
+  memset(st, 0, sizeof(*st)); // counter and nonce
+  st->in[0] = 0x61707865; // "expand 32-byte k"
+  st->in[1] = 0x3320646e;
+  st->in[2] = 0x79622d32;
+  st->in[3] = 0x6b206574;
+  for (int i = 0; i < 4; ++i) {
+    st->in[4 + 2*i] = (uint32_t)key[i];
+    st->in[5 + 2*i] = (uint32_t)(key[i] >> 32);
+  }
+}
+
+GCC_ATTRIB(nothrow,nonnull)
+INLINE void ChaCha8_fill(ChaCha8_State * st, uint32_t * ks, uint32_t n_words)
+{
+  for (uint32_t w = 0; w < n_words; w += 128) {
+    adler_kernel->chacha8_x8(st->in, ks + w);
+    st->in[12] += 8;
+    if (st->in[12] == 0) ++st->in[13];
+  }
+}
+
+// AES-128 in counter mode: the key is the 2 tempered words of the original
+// Xoroshiro128+ state, the nonce is the 3rd tempered word, and the counter
+// starts at 0. It is generated 8 blocks, 32 words, at a time by the
+// adler_aes_ctr8 kernel, i.e. VAES or AES-NI with the 8 blocks pipelined, or
+// the software AES.
+
+typedef struct {
+  uint8_t rk[176]; // the expanded key
+  uint64_t nonce;
+  uint64_t ctr;
+} AESCTR_State;
+
+GCC_ATTRIB(nothrow,nonnull)
+INLINE void AESCTR_seed(AESCTR_State * st, const uint64_t iv[2], uint64_t seed)
+{
+  uint64_t w[3];
+  uint8_t key[16];
+  cipherTemper64(w, 3, iv, seed);
+
+  for (int b = 0; b < 8; ++b) { // little endian
+    key[b] = (uint8_t)(w[0] >> (8*b));
+    key[8+b] = (uint8_t)(w[1] >> (8*b));
+  }
+
+  aesExpandKey128(key, st->rk);
+  st->nonce = w[2];
+  st->ctr = 0;
+}
+
+GCC_ATTRIB(nothrow,nonnull)
+INLINE void AESCTR_fill(AESCTR_State * st, uint32_t * ks, uint32_t n_words)
+{
+  for (uint32_t w = 0; w < n_words; w += 32) {
+    adler_aes_ctr8(st->rk, st->ctr, st->nonce, ks + w);
+    st->ctr += 8;
+  }
+}
+
+CIPHER_HASH_FUNCS(Xoroshiro128Plus)
+CIPHER_HASH_FUNCS(Xorshift1024Star)
+CIPHER_HASH_FUNCS(Xoshiro256StarStar)
+CIPHER_HASH_FUNCS(ChaCha8)
+CIPHER_HASH_FUNCS(AESCTR)
+
+#undef CIPHER_HASH_FUNCS
+
+// The original variant. tempered is the PRNG state after tempering the iv
+// and the seed.
+
+GCC_ATTRIB(nothrow,nonnull,pure)
+static uint64_t cipherHashTempered64(const uint8_t * msg, size_t n_bytes, const uint64_t tempered[2])
+{
+  const Xoroshiro128Plus_State st = { { tempered[0], tempered[1] } };
+
+  return cipherHashState_Xoroshiro128Plus(msg, n_bytes, &st);
+}
+
+GCC_ATTRIB(nothrow,nonnull,pure)
+static uint64_t cipherHash64(const uint8_t * msg, size_t n_bytes, const uint64_t iv[2], uint64_t seed)
+{
+  return cipherHash_Xoroshiro128Plus(msg, n_bytes, iv, seed);
+}
+
+// The cipher sum of len whole words from the even word pos of a block, with
+// the PRNG state s, for the streaming and the keyed funcs, whose state is a
+// plain uint64_t[2]. s ends up after (len+1)/2 draws.
+
+GCC_ATTRIB(nothrow,nonnull)
+static uint64_t cipherSum64(const uint8_t * msg, uint32_t len, uint32_t pos, uint64_t s[2])
+{
+  assert((pos & 1) == 0);
+
+  Xoroshiro128Plus_State st = { { s[0], s[1] } };
+  uint64_t adler_sum = cipherSum_Xoroshiro128Plus(msg, len, pos, &st, 0);
+
+  s[0] = st.s[0];
+  s[1] = st.s[1];
+
+  return adler_sum;
+}
+
+/*
+  The v2 cipher format: CIPHER_LANES independent Xoroshiro128+ lanes, lane l
+  tempered from words 2l and 2l+1 of cipherTemper64() with the iv XORed
+  with CIPHER_V2_TAG, so that no lane shares tempered state with the
+  original variant or with the other generators. Draw d of lane l masks the
+  word pair l of 16-word group d, i.e. each lane masks a 64-byte stride of
+  the message, and a 64-byte group is one 512-bit vector of draws. Every
+  block starts with a fresh draw of every lane. The weighted sum of a block
+  is the sum of the weighted sums of the lanes, which goes into the block
+  chain as usual. The cipher_v2sum64 kernel takes the whole groups of a
+  block, and the last partial group, with the padded tail word, goes
+  through a local pad. Its digests differ from those
+  of the original variant: it is a new format, not a faster implementation.
+*/
+
+#define CIPHER_V2_TAG UINT64_C(0x76322d6c616e6573) // "v2-lanes"
+
+typedef struct {
+  uint64_t s0[CIPHER_LANES];
+  uint64_t s1[CIPHER_LANES];
+} CipherV2_State;
+
+GCC_ATTRIB(nothrow,nonnull)
+INLINE void CipherV2_seed(CipherV2_State * st, const uint64_t iv[2], uint64_t seed)
+{
+  const uint64_t iv2[2] = { iv[0] ^ CIPHER_V2_TAG, iv[1] ^ CIPHER_V2_TAG };
+  uint64_t w[2*CIPHER_LANES];
+  cipherTemper64(w, 2*CIPHER_LANES, iv2, seed);
+
+  for (uint32_t l = 0; l < CIPHER_LANES; ++l) {
+    st->s0[l] = w[2*l];
+    st->s1[l] = w[2*l + 1];
+  }
+}
+
+GCC_ATTRIB(nothrow,nonnull)
+static uint64_t cipherBlockSumV2(const uint8_t * msg, uint32_t len, uint32_t tail_bytes, CipherV2_State * st)
+{
+  uint32_t whole = (tail_bytes) ? len - 1 : len; // words read straight from msg
+  uint32_t bulk = whole & ~UINT32_C(15);
+
+  uint64_t adler_sum = adler_kernel->cipher_v2sum64(msg, bulk, 0, st->s0, st->s1);
+
+  if (bulk < len) {
+    uint8_t pad[64];
+    uint32_t ks[16];
+    memset(pad, 0, sizeof(pad));
+    memcpy(pad, msg + 4*bulk, 4*(whole - bulk) + tail_bytes);
+    cipherKeystreamV2_scalar(st->s0, st->s1, ks, 1);
+    adler_sum += cipherXorSum64_scalar(pad, ks, len - bulk, bulk);
+  }
+
+  return adler_sum;
+}
+
+GCC_ATTRIB(nothrow,nonnull,pure)
+static uint64_t cipherHashV2(const uint8_t * msg, size_t n_bytes, const uint64_t iv[2], uint64_t seed)
+{
+  uint64_t hash_code;
+
+  CipherV2_State st;
+  CipherV2_seed(&st, iv, seed);
+
+  ADLER_BLOCK_WALK(uint64_t, hash_code, n_bytes, 4, ADLER64_BLOCK_LEN, adlerLcgA64, adlerChain64,
+    cipherBlockSumV2(msg + 4*k, len, tail, &st));
+
+  return hash_code;
+}
+
+GCC_ATTRIB(nothrow,nonnull,pure)
+uint32_t AYBern_adlerHash32(const uint16_t * msg, uint32_t n)
+{
+  return adlerHash32((const uint8_t *)msg, 2*(size_t)n);
+}
+
+GCC_ATTRIB(nothrow,nonnull,pure)
+uint64_t AYBern_adlerHash64(const uint32_t * msg, uint32_t n)
+{
+  return adlerHash64((const uint8_t *)msg, 4*(size_t)n);
+}
+
+GCC_ATTRIB(nothrow,nonnull,pure)
+uint64_t AYBern_adlerHashCipherXorshift128_64(const uint32_t * msg, uint32_t n, const uint64_t iv[2], uint64_t seed)
+{
+  return cipherHash64((const uint8_t *)msg, 4*(size_t)n, iv, seed);
+}
+
+GCC_ATTRIB(nothrow,nonnull(1),pure)
+uint32_t AYBern_adlerHash32Mem(const void * msg, size_t n_bytes)
+{
+  return adlerHash32((const uint8_t *)msg, n_bytes);
+}
+
+GCC_ATTRIB(nothrow,nonnull(1),pure)
+uint64_t AYBern_adlerHash64Mem(const void * msg, size_t n_bytes)
+{
+  return adlerHash64((const uint8_t *)msg, n_bytes);
+}
+
+GCC_ATTRIB(nothrow,nonnull(1,3),pure)
+uint64_t AYBern_adlerHashCipherXorshift128_64Mem(const void * msg, size_t n_bytes, const uint64_t iv[2], uint64_t seed)
+{
+  return cipherHash64((const uint8_t *)msg, n_bytes, iv, seed);
+}
+
+GCC_ATTRIB(nothrow,nonnull,pure)
+uint32_t AYBern_adlerHashCipher32(const uint16_t * msg, uint32_t n, const uint32_t iv[2], uint32_t seed)
+{
+  return cipherHash32((const uint8_t *)msg, 2*(size_t)n, iv, seed);
+}
+
+GCC_ATTRIB(nothrow,nonnull(1,3),pure)
+uint32_t AYBern_adlerHashCipher32Mem(const void * msg, size_t n_bytes, const uint32_t iv[2], uint32_t seed)
+{
+  return cipherHash32((const uint8_t *)msg, n_bytes, iv, seed);
+}
+
+// The wide hash64 formats
+
+GCC_ATTRIB(nothrow,nonnull,pure)
+uint64_t AYBern_adlerHash64x4(const uint32_t * msg, uint32_t n)
+{
+  return adlerHash64Wide((const uint8_t *)msg, 4*(size_t)n, 4);
+}
+
+GCC_ATTRIB(nothrow,nonnull,pure)
+uint64_t AYBern_adlerHash64x4Mem(const void * msg, size_t n_bytes)
+{
+  return adlerHash64Wide((const uint8_t *)msg, n_bytes, 4);
+}
+
+GCC_ATTRIB(nothrow,nonnull,pure)
+uint64_t AYBern_adlerHash64x8(const uint32_t * msg, uint32_t n)
+{
+  return adlerHash64Wide((const uint8_t *)msg, 4*(size_t)n, 8);
+}
+
+GCC_ATTRIB(nothrow,nonnull,pure)
+uint64_t AYBern_adlerHash64x8Mem(const void * msg, size_t n_bytes)
+{
+  return adlerHash64Wide((const uint8_t *)msg, n_bytes, 8);
+}
+
+// The cipher variants with the other keystream generators
+
+GCC_ATTRIB(nothrow,nonnull,pure)
+uint64_t AYBern_adlerHashCipherXorshift1024_64(const uint32_t * msg, uint32_t n, const uint64_t iv[2], uint64_t seed)
+{
+  return cipherHash_Xorshift1024Star((const uint8_t *)msg, 4*(size_t)n, iv, seed);
+}
+
+GCC_ATTRIB(nothrow,nonnull(1,3),pure)
+uint64_t AYBern_adlerHashCipherXorshift1024_64Mem(const void * msg, size_t n_bytes, const uint64_t iv[2], uint64_t seed)
+{
+  return cipherHash_Xorshift1024Star((const uint8_t *)msg, n_bytes, iv, seed);
+}
+
+GCC_ATTRIB(nothrow,nonnull,pure)
+uint64_t AYBern_adlerHashCipherXoshiro256_64(const uint32_t * msg, uint32_t n, const uint64_t iv[2], uint64_t seed)
+{
+  return cipherHash_Xoshiro256StarStar((const uint8_t *)msg, 4*(size_t)n, iv, seed);
+}
+
+GCC_ATTRIB(nothrow,nonnull(1,3),pure)
+uint64_t AYBern_adlerHashCipherXoshiro256_64Mem(const void * msg, size_t n_bytes, const uint64_t iv[2], uint64_t seed)
+{
+  return cipherHash_Xoshiro256StarStar((const uint8_t *)msg, n_bytes, iv, seed);
+}
+
+GCC_ATTRIB(nothrow,nonnull,pure)
+uint64_t AYBern_adlerHashCipherChaCha8_64(const uint32_t * msg, uint32_t n, const uint64_t iv[2], uint64_t seed)
+{
+  return cipherHash_ChaCha8((const uint8_t *)msg, 4*(size_t)n, iv, seed);
+}
+
+GCC_ATTRIB(nothrow,nonnull(1,3),pure)
+uint64_t AYBern_adlerHashCipherChaCha8_64Mem(const void * msg, size_t n_bytes, const uint64_t iv[2], uint64_t seed)
+{
+  return cipherHash_ChaCha8((const uint8_t *)msg, n_bytes, iv, seed);
+}
+
+GCC_ATTRIB(nothrow,nonnull,pure)
+uint64_t AYBern_adlerHashCipherAESCTR_64(const uint32_t * msg, uint32_t n, const uint64_t iv[2], uint64_t seed)
+{
+  return cipherHash_AESCTR((const uint8_t *)msg, 4*(size_t)n, iv, seed);
+}
+
+GCC_ATTRIB(nothrow,nonnull(1,3),pure)
+uint64_t AYBern_adlerHashCipherAESCTR_64Mem(const void * msg, size_t n_bytes, const uint64_t iv[2], uint64_t seed)
+{
+  return cipherHash_AESCTR((const uint8_t *)msg, n_bytes, iv, seed);
+}
+
+GCC_ATTRIB(nothrow,nonnull,pure)
+uint64_t AYBern_adlerHashCipherV2_64(const uint32_t * msg, uint32_t n, const uint64_t iv[2], uint64_t seed)
+{
+  return cipherHashV2((const uint8_t *)msg, 4*(size_t)n, iv, seed);
+}
+
+GCC_ATTRIB(nothrow,nonnull(1,3),pure)
+uint64_t AYBern_adlerHashCipherV2_64Mem(const void * msg, size_t n_bytes, const uint64_t iv[2], uint64_t seed)
+{
+  return cipherHashV2((const uint8_t *)msg, n_bytes, iv, seed);
+}
+
+/*
+  ZLIB ADLER-32
+
+  The legacy checksum, bit for bit zlib's adler32() and adler32_combine(),
+  so that the digests already stored with old data can be verified by the
+  same library that computes the new ones.
+*/
+
+GCC_ATTRIB(nothrow,pure)
+uint32_t AYBern_adler32Zlib(uint32_t adler, const void * msg, size_t n_bytes)
+{
+  if (!msg) return 1; // zlib: the initial value
+
+  return adler_kernel->zlib_adler32(adler, (const uint8_t *)msg, n_bytes);
+}
+
+// The Adler-32 of the concatenation of 2 messages, from their Adler-32's and
+// the length of the 2nd: s1 = s1a + s1b - 1, and s2 = s2a + s2b - 1 +
+// len2 * (s1a - 1), since every byte of the 2nd message sees s1a - 1 more
+// in its s1 than it did on its own, all mod ZLIB_BASE.
+
+GCC_ATTRIB(nothrow,const)
+uint32_t AYBern_adler32ZlibCombine(uint32_t adler1, uint32_t adler2, uint64_t len2)
+{
+  const uint64_t base = ZLIB_BASE;
+  uint64_t rem = len2 % base;
+  uint64_t s1a = adler1 & 0xffff, s2a = adler1 >> 16;
+  uint64_t s1b = adler2 & 0xffff, s2b = adler2 >> 16;
+
+  uint64_t s1 = (s1a + s1b + base - 1) % base;
+  uint64_t s2 = (s2a + s2b + rem * s1a + base - rem) % base; // - rem: the -1 of s1a, len2 times
+
+  return (uint32_t)(s1 | (s2 << 16));
+}
+
+/*
+  ENCRYPT AND HASH
+
+  A single pass over the message which both encrypts it and computes its
+  cipher hash: the digest is exactly AYBern_adlerHashCipherXorshift128_64Mem()
+  of the plaintext, so a receiver may also verify it the old way. The
+  encryption keystream is NOT the hash keystream, though. The hash sums
+  msg ^ keystream, so encrypting with the same keystream would turn the
+  digest into a public function of the ciphertext, which anyone could
+  recompute after tampering with it. The encryption keystream is a 2nd
+  Xoroshiro128+, whose state is tempered words 2 and 3 of the (iv, seed),
+  see cipherTemper64(). Both keystreams are generated a buffer at a time
+  into L1, so the message itself is still read once and written once.
+
+  Decryption sums the plaintext, i.e. ciphertext ^ enc ^ hash keystream,
+  so it XORs the 2 keystream buffers first and uses the same kernel.
+*/
+
+// The cipher sum of a block of len words, which is encrypted (or decrypted)
+// from in to out, with the hash keystream s_sum and the encryption
+// keystream s_out. With tail_bytes, only those bytes of the last word are
+// read and stored.
+
+GCC_ATTRIB(nothrow,nonnull)
+static uint64_t cipherCryptBlockSum64(const uint8_t * in, uint8_t * out, uint32_t len, uint32_t tail_bytes,
+    Xoroshiro128Plus_State * s_sum, Xoroshiro128Plus_State * s_out, int decrypt)
+{
+  uint32_t ks_sum[CIPHER_KS_WORDS], ks_out[CIPHER_KS_WORDS];
+  uint64_t adler_sum = 0;
+
+  for (uint32_t i = 0; i < len; i += CIPHER_KS_WORDS) {
+    uint32_t m = (len - i < CIPHER_KS_WORDS) ? len - i : CIPHER_KS_WORDS;
+    const uint8_t * p = in + 4*i;
+    uint8_t * q = out + 4*i;
+
+    Xoroshiro128Plus_fill(s_sum, ks_sum, m);
+    Xoroshiro128Plus_fill(s_out, ks_out, m);
+    if (decrypt) {
+      for (uint32_t w = 0; w < m; ++w) ks_sum[w] ^= ks_out[w];
+    }
+
+    if (tail_bytes && i + m == len) { // the padded tail word: only tail bytes are stored
+      adler_sum += adler_kernel->cipher_xcrypt64(p, q, ks_out, ks_sum, m - 1, i);
+
+      uint8_t pad[4] = { 0, 0, 0, 0 };
+      memcpy(pad, p + 4*(m - 1), tail_bytes);
+      uint32_t w = load32(pad);
+      uint32_t x = w ^ ks_out[m - 1];
+      memcpy(pad, &x, sizeof(x));
+      memcpy(q + 4*(m - 1), pad, tail_bytes);
+
+      memset(pad + tail_bytes, 0, 4 - tail_bytes); // the zero padded plaintext word
+      uint32_t pt = (decrypt) ? load32(pad) : w;
+      uint32_t mask = (decrypt) ? ks_sum[m - 1] ^ ks_out[m - 1] : ks_sum[m - 1];
+      adler_sum += (uint64_t)(i + m) * (uint64_t)(pt ^ mask);
+    } else {
+      adler_sum += adler_kernel->cipher_xcrypt64(p, q, ks_out, ks_sum, m, i);
+    }
+  }
+
+  return adler_sum;
+}
+
+GCC_ATTRIB(nothrow,nonnull)
+static uint64_t cipherCrypt64(const uint8_t * in, uint8_t * out, size_t n_bytes,
+    const uint64_t iv[2], uint64_t seed, int decrypt)
+{
+  uint64_t hash_code;
+
+  uint64_t tempered[4];
+  cipherTemper64(tempered, 4, iv, seed);
+  Xoroshiro128Plus_State s_sum = { { tempered[0], tempered[1] } }; // the hash keystream
+  Xoroshiro128Plus_State s_out = { { tempered[2], tempered[3] } }; // the encryption keystream
+
+  ADLER_BLOCK_WALK(uint64_t, hash_code, n_bytes, 4, ADLER64_BLOCK_LEN, adlerLcgA64, adlerChain64,
+    cipherCryptBlockSum64(in + 4*k, out + 4*k, len, tail, &s_sum, &s_out, decrypt));
+
+  return hash_code;
+}
+
+GCC_ATTRIB(nothrow,nonnull(1,2,4))
+uint64_t AYBern_adlerHashCipherXorshift128_64Encrypt(const void * msg, void * out, size_t n_bytes,
+    const uint64_t iv[2], uint64_t seed)
+{
+  return cipherCrypt64((const uint8_t *)msg, (uint8_t *)out, n_bytes, iv, seed, 0);
+}
+
+GCC_ATTRIB(nothrow,nonnull(1,2,4))
+int AYBern_adlerHashCipherXorshift128_64Decrypt(const void * msg, void * out, size_t n_bytes,
+    const uint64_t iv[2], uint64_t seed, uint64_t hash_code)
+{
+  return (cipherCrypt64((const uint8_t *)msg, (uint8_t *)out, n_bytes, iv, seed, 1) == hash_code) ? 0 : -1;
+}
+
+/*
+  COPY AND HASH
+
+  Copy a message to out and return its digest, in a single pass: every word
+  is loaded once, stored to out, and summed in the same loop, rather than a
+  memcpy() followed by a hash which reads the copy back. The digests are
+  exactly those of the Mem funcs, with the same ADLER_BLOCK_WALK(). With
+  AYBERN_COPY_NONTEMPORAL the stores bypass the cache, when out is aligned
+  to the vector size, which helps when the copy will not be read soon.
+*/
+
+#define ADLER_COPY_NT(flags) (((flags) & AYBERN_COPY_NONTEMPORAL) != 0)
+
+// The copy-and-hash block sums: a block of len words from in to out, with
+// the copy_sum kernels. With tail_bytes, only those bytes of the last word
+// are read and stored, and it is summed through a zero pad.
+
+GCC_ATTRIB(nothrow,nonnull)
+static uint32_t adlerCopyBlockSum32(const uint8_t * in, uint8_t * out, uint32_t len, uint32_t tail_bytes, int nt)
+{
+  uint32_t whole = len - (tail_bytes != 0);
+  uint32_t adler_sum = adler_kernel->copy_sum32(in, out, whole, 0, nt);
+
+  if (whole < len) { // the padded tail word
+    uint8_t pad[2] = { 0, 0 };
+    memcpy(pad, in + 2*whole, tail_bytes);
+    memcpy(out + 2*whole, pad, tail_bytes);
+    adler_sum += len * load16(pad);
+  }
+
+  return adler_sum;
+}
+
+GCC_ATTRIB(nothrow,nonnull)
+static uint64_t adlerCopyBlockSum64(const uint8_t * in, uint8_t * out, uint32_t len, uint32_t tail_bytes, int nt)
+{
+  uint32_t whole = len - (tail_bytes != 0);
+  uint64_t adler_sum = adler_kernel->copy_sum64(in, out, whole, 0, nt);
+
+  if (whole < len) { // the padded tail word
+    uint8_t pad[4] = { 0, 0, 0, 0 };
+    memcpy(pad, in + 4*whole, tail_bytes);
+    memcpy(out + 4*whole, pad, tail_bytes);
+    adler_sum += (uint64_t)len * (uint64_t)load32(pad);
+  }
+
+  return adler_sum;
+}
+
+// the cipher sum, with the hash keystream st of cipherCrypt64()
+
+GCC_ATTRIB(nothrow,nonnull)
+static uint64_t cipherCopyBlockSum64(const uint8_t * in, uint8_t * out, uint32_t len, uint32_t tail_bytes,
+    Xoroshiro128Plus_State * st, int nt)
+{
+  uint32_t ks[CIPHER_KS_WORDS];
+  uint64_t adler_sum = 0;
+
+  for (uint32_t i = 0; i < len; i += CIPHER_KS_WORDS) {
+    uint32_t m = (len - i < CIPHER_KS_WORDS) ? len - i : CIPHER_KS_WORDS;
+    const uint8_t * p = in + 4*i;
+    uint8_t * q = out + 4*i;
+
+    Xoroshiro128Plus_fill(st, ks, m);
+
+    if (tail_bytes && i + m == len) { // the padded tail word
+      adler_sum += adler_kernel->cipher_copy_sum64(p, q, ks, m - 1, i, nt);
+
+      uint8_t pad[4] = { 0, 0, 0, 0 };
+      memcpy(pad, p + 4*(m - 1), tail_bytes);
+      memcpy(q + 4*(m - 1), pad, tail_bytes);
+      adler_sum += (uint64_t)(i + m) * (uint64_t)(load32(pad) ^ ks[m - 1]);
+    } else {
+      adler_sum += adler_kernel->cipher_copy_sum64(p, q, ks, m, i, nt);
+    }
+  }
+
+  return adler_sum;
+}
+
+GCC_ATTRIB(nothrow,nonnull)
+static uint32_t adlerCopyHash32(const uint8_t * in, uint8_t * out, size_t n_bytes, int nt)
+{
+  uint32_t hash_code;
+
+  ADLER_BLOCK_WALK(uint32_t, hash_code, n_bytes, 2, ADLER32_BLOCK_LEN, adlerLcgA32, adlerChain32,
+    adlerCopyBlockSum32(in + 2*k, out + 2*k, len, tail, nt));
+
+  if (nt) adlerStoreFence();
+
+  return hash_code;
+}
+
+GCC_ATTRIB(nothrow,nonnull)
+static uint64_t adlerCopyHash64(const uint8_t * in, uint8_t * out, size_t n_bytes, int nt)
+{
+  uint64_t hash_code;
+
+  ADLER_BLOCK_WALK(uint64_t, hash_code, n_bytes, 4, ADLER64_BLOCK_LEN, adlerLcgA64, adlerChain64,
+    adlerCopyBlockSum64(in + 4*k, out + 4*k, len, tail, nt));
+
+  if (nt) adlerStoreFence();
+
+  return hash_code;
+}
+
+GCC_ATTRIB(nothrow,nonnull)
+static uint64_t cipherCopyHash64(const uint8_t * in, uint8_t * out, size_t n_bytes,
+    const uint64_t iv[2], uint64_t seed, int nt)
+{
+  uint64_t hash_code;
+
+  Xoroshiro128Plus_State st; // the hash keystream of cipherCrypt64()
+  Xoroshiro128Plus_seed(&st, iv, seed);
+
+  ADLER_BLOCK_WALK(uint64_t, hash_code, n_bytes, 4, ADLER64_BLOCK_LEN, adlerLcgA64, adlerChain64,
+    cipherCopyBlockSum64(in + 4*k, out + 4*k, len, tail, &st, nt));
+
+  if (nt) adlerStoreFence();
+
+  return hash_code;
+}
+
+GCC_ATTRIB(nothrow,nonnull)
+uint32_t AYBern_adlerHash32Copy(const void * msg, void * out, size_t n_bytes, unsigned flags)
+{
+  return adlerCopyHash32((const uint8_t *)msg, (uint8_t *)out, n_bytes, ADLER_COPY_NT(flags));
+}
+
+GCC_ATTRIB(nothrow,nonnull)
+uint64_t AYBern_adlerHash64Copy(const void * msg, void * out, size_t n_bytes, unsigned flags)
+{
+  return adlerCopyHash64((const uint8_t *)msg, (uint8_t *)out, n_bytes, ADLER_COPY_NT(flags));
+}
+
+GCC_ATTRIB(nothrow,nonnull)
+uint64_t AYBern_adlerHashCipherXorshift128_64Copy(const void * msg, void * out, size_t n_bytes,
+    const uint64_t iv[2], uint64_t seed, unsigned flags)
+{
+  return cipherCopyHash64((const uint8_t *)msg, (uint8_t *)out, n_bytes, iv, seed, ADLER_COPY_NT(flags));
+}
+
+#undef ADLER_COPY_NT
+
+/*
+  KEYED
+
+  A key schedule for verifying many messages under the same (iv, seed). The
+  tempered PRNG state is computed once, and optionally so is the keystream of
+  the first max_bytes of a message. Since the mask of word i of a message is
+  always 32-bit half i of the sequence of draws (every whole block takes
+  exactly 2^16 draws and the last block starts with a fresh one), a cached
+  keystream turns the cipher sum into the XOR-and-weighted-sum cipher_xsum64
+  kernel, with no PRNG and no parity in the loop. A message which is longer
+  than the cache generates its keystream from the cached tempered state.
+  The cache costs max_bytes of memory.
+*/
+
+struct AYBern_CipherKey {
+  uint64_t s[2]; // the tempered state
+  uint32_t * ks; // the keystream of the first ks_words words, or NULL
+  size_t ks_words; // even
+};
+
+GCC_ATTRIB(nothrow,nonnull(1))
+AYBern_CipherKey * AYBern_cipherKeyCreate(const uint64_t iv[2], uint64_t seed, size_t max_bytes)
+{
+  AYBern_CipherKey * key = (AYBern_CipherKey *)calloc(1, sizeof(AYBern_CipherKey));
+  if (!key) return NULL;
+
+  // temper the iv
+  key->s[0] = SplitMix_next(iv[0]^seed);
+  key->s[1] = SplitMix_next(iv[1]);
+
+  size_t n_draws = max_bytes/8 + ((max_bytes & 7) != 0); // 2 words per draw
+
+  if (n_draws) {
+    key->ks = (uint32_t *)malloc(n_draws * sizeof(uint64_t));
+    if (!key->ks) {
+      free(key);
+      return NULL;
+    }
+
+    Xoroshiro128Plus_State st = { { key->s[0], key->s[1] } };
+    Xoroshiro128Plus_fill(&st, key->ks, 2*n_draws);
+    key->ks_words = 2*n_draws;
+  }
+
+  return key;
+}
+
+GCC_ATTRIB(nothrow)
+void AYBern_cipherKeyDestroy(AYBern_CipherKey * key)
+{
+  if (!key) return;
+
+  free(key->ks);
+  free(key);
+}
+
+GCC_ATTRIB(nothrow,nonnull)
+static uint64_t cipherKeyedBlockSum64(const uint8_t * msg, const uint32_t * ks, uint32_t len, uint32_t tail_bytes)
+{
+  if (!tail_bytes) return adler_kernel->cipher_xsum64(msg, ks, len, 0);
+
+  uint32_t whole = len - 1;
+  uint8_t pad[4] = { 0, 0, 0, 0 };
+  memcpy(pad, msg + 4*whole, tail_bytes);
+
+  return adler_kernel->cipher_xsum64(msg, ks, whole, 0) + adler_kernel->cipher_xsum64(pad, ks + whole, 1, whole);
+}
+
+GCC_ATTRIB(nothrow,nonnull,pure)
+uint64_t AYBern_adlerHashCipherXorshift128_64Keyed(const AYBern_CipherKey * key, const void * msg, size_t n_bytes)
+{
+  size_t n = n_bytes/4 + ((n_bytes & 3) != 0); // including the padded tail word
+
+  if (n > key->ks_words) return cipherHashTempered64((const uint8_t *)msg, n_bytes, key->s);
+
+  uint64_t hash_code;
+
+  ADLER_BLOCK_WALK(uint64_t, hash_code, n_bytes, 4, ADLER64_BLOCK_LEN, adlerLcgA64, adlerChain64,
+    cipherKeyedBlockSum64((const uint8_t *)msg + 4*k, key->ks + k, len, tail));
+
+  return hash_code;
+}
+
+/*
+  BATCH
+
+  Symbol tables, ARP/MAC tables and the like hash millions of tiny keys, where
+  the per-call overhead, the last_lcg_a division and the serial mixer cost
+  more than the sum itself. A key of at most one block is a single chain step
+  with j = 0, so the keys are independent of each other: we compute the sums
+  one key at a time with the sum32 kernel, and then the lcg and the mixer 16
+  keys at a time in SIMD lanes with the mix32 kernel. Keys of up to 64 bytes
+  use the unrolled short sum instead, since the kernels are tuned for whole
+  blocks. Keys which span more than one block take the regular one-shot path.
+*/
+
+#define ADLER_BATCH 16
+
+GCC_ATTRIB(nothrow,nonnull)
+void AYBern_adlerHash32Batch(const void * const * keys, const size_t * n_bytes, uint32_t * hash_codes, size_t count)
+{
+  uint32_t sums[ADLER_BATCH], lens[ADLER_BATCH], out[ADLER_BATCH];
+
+  for (size_t i = 0; i < count; i += ADLER_BATCH) { // batch loop: begin
+    uint32_t m = (count - i < ADLER_BATCH) ? (uint32_t)(count - i) : ADLER_BATCH;
+
+    for (uint32_t b = 0; b < ADLER_BATCH; ++b) {
+      size_t nb = (b < m) ? n_bytes[i+b] : 0;
+      if (nb == 0 || nb > 2*ADLER32_BLOCK_LEN) { // unused lane, empty or long key
+        sums[b] = 0;
+        lens[b] = 1;
+        continue;
+      }
+      lens[b] = (uint32_t)(nb/2 + (nb & 1));
+      sums[b] = (nb <= ADLER_SHORT_BYTES) ? adler_kernel->short_sum32((const uint8_t *)keys[i+b], (uint32_t)nb)
+        : adlerBlockSum32((const uint8_t *)keys[i+b], lens[b], nb & 1);
+    }
+
+    if (adler_kernel->mix32) {
+      adler_kernel->mix32(sums, lens, out);
+    } else {
+      for (uint32_t b = 0; b < m; ++b) out[b] = adlerChain32(0, sums[b], adlerLcgA32(lens[b]), 0);
+    }
+
+    for (uint32_t b = 0; b < m; ++b) {
+      size_t nb = n_bytes[i+b];
+      if (nb == 0) {
+        hash_codes[i+b] = 0;
+      } else if (nb > 2*ADLER32_BLOCK_LEN) {
+        hash_codes[i+b] = adlerHash32((const uint8_t *)keys[i+b], nb);
+      } else {
+        hash_codes[i+b] = out[b];
+      }
+    }
+  } // batch loop: end
+}
+
+/*
+  Cipher batch, in the style of multi-buffer SHA: CIPHER_LANES messages, each
+  with its own (iv, seed), are hashed side by side, so that the serial PRNGs
+  of the lanes are stepped together in SIMD lanes by the cipher_ks8 kernel.
+  Every step takes one keystream buffer, CIPHER_KS_WORDS words, of each lane,
+  and the cipher_xsum64 kernel sums it against that lane's message. Since a
+  block is a whole number of buffers, a lane only needs less than a full
+  buffer in the last step of its message, and a lane whose message is done
+  is refilled with the next message, so the lanes stay busy whatever the
+  lengths. Every lane follows the block chain of cipherHashTempered64().
+*/
+
+typedef struct {
+  const uint8_t * msg;
+  size_t n; // words, including the padded tail word
+  size_t k; // words done
+  uint32_t tail_bytes;
+  uint32_t pos; // words done in the current block
+  uint64_t j;
+  uint64_t adler_sum;
+  uint64_t hash_code;
+  size_t out; // index into hash_codes, or SIZE_MAX for an idle lane
+} CipherLane;
+
+GCC_ATTRIB(nothrow,nonnull)
+void AYBern_adlerHashCipherXorshift128_64Batch(const void * const * msgs, const size_t * n_bytes,
+    const uint64_t (*ivs)[2], const uint64_t * seeds, uint64_t * hash_codes, size_t count)
+{
+  const uint32_t block_len = ADLER64_BLOCK_LEN;
+
+  uint32_t ks[CIPHER_LANES][CIPHER_KS_WORDS];
+  uint64_t s0[CIPHER_LANES] = { 0 }, s1[CIPHER_LANES] = { 0 }; // idle lanes are stepped too
+  CipherLane lanes[CIPHER_LANES];
+
+  size_t next = 0; // the next message to start
+  uint32_t active = 0;
+
+  for (uint32_t l = 0; l < CIPHER_LANES; ++l) lanes[l].out = SIZE_MAX;
+
+  for (;;) { // step loop: begin
+
+    for (uint32_t l = 0; l < CIPHER_LANES; ++l) { // refill the idle lanes
+      CipherLane * lane = &lanes[l];
+      while (lane->out == SIZE_MAX && next < count) {
+        size_t i = next++;
+        if (n_bytes[i] == 0) {
+          hash_codes[i] = 0;
+          continue;
+        }
+        memset(lane, 0, sizeof(*lane));
+        lane->msg = (const uint8_t *)msgs[i];
+        lane->n = n_bytes[i]/4 + ((n_bytes[i] & 3) != 0);
+        lane->tail_bytes = n_bytes[i] & 3;
+        lane->out = i;
+        // temper the iv
+        s0[l] = SplitMix_next(ivs[i][0]^seeds[i]);
+        s1[l] = SplitMix_next(ivs[i][1]);
+        ++active;
+      }
+    }
+
+    if (!active) break;
+
+    uint32_t n_draws = 0;
+    for (uint32_t l = 0; l < CIPHER_LANES; ++l) {
+      if (lanes[l].out == SIZE_MAX) continue;
+      size_t rest = lanes[l].n - lanes[l].k;
+      uint32_t d = (rest < CIPHER_KS_WORDS) ? (uint32_t)(rest + 1)/2 : CIPHER_KS_WORDS/2;
+      if (d > n_draws) n_draws = d;
+    }
+
+    adler_kernel->cipher_ks8(s0, s1, ks, n_draws);
+
+    for (uint32_t l = 0; l < CIPHER_LANES; ++l) { // lane loop: begin
+      CipherLane * lane = &lanes[l];
+      if (lane->out == SIZE_MAX) continue;
+
+      size_t rest = lane->n - lane->k;
+      uint32_t len = (rest < CIPHER_KS_WORDS) ? (uint32_t)rest : CIPHER_KS_WORDS;
+      const uint8_t * msg = lane->msg + 4*lane->k;
+
+      if (len == rest && lane->tail_bytes) { // the padded tail word
+        uint8_t pad[4] = { 0, 0, 0, 0 };
+        memcpy(pad, msg + 4*(len - 1), lane->tail_bytes);
+        lane->adler_sum += adler_kernel->cipher_xsum64(msg, ks[l], len - 1, lane->pos);
+        lane->adler_sum += adler_kernel->cipher_xsum64(pad, ks[l] + len - 1, 1, lane->pos + len - 1);
+      } else {
+        lane->adler_sum += adler_kernel->cipher_xsum64(msg, ks[l], len, lane->pos);
+      }
+
+      lane->pos += len;
+      lane->k += len;
+
+      if (lane->pos == block_len || lane->k == lane->n) { // the end of a block
+        lane->hash_code = adlerChain64(lane->hash_code, lane->adler_sum, adlerLcgA64(lane->pos), lane->j++);
+        lane->adler_sum = 0;
+        lane->pos = 0;
+      }
+
+      if (lane->k == lane->n) { // the end of the message
+        hash_codes[lane->out] = lane->hash_code;
+        lane->out = SIZE_MAX;
+        --active;
+      }
+    } // lane loop: end
+  } // step loop: end
+}
+
+/*
+  STREAMING
+
+  init/update/final contexts which produce exactly the one-shot results for
+  a message that arrives in chunks of any size. We never need to buffer a
+  block: a full block always has lcg_a = 1, whether or not it turns out to
+  be the last one, so it can be chained as soon as it is complete. Only the
+  final partial block needs last_lcg_a, and final() knows its length.
+
+  update() takes bytes. Words are assembled in native byte order, exactly as
+  when a byte buffer is cast to uint16_t/uint32_t for the one-shot funcs, and
+  a word which is split between 2 chunks is carried in ctx->tail. If the
+  message does not end on a word boundary, final() pads it with zero bytes.
+  final() does not modify the context, so it can also be used to take an
+  intermediate digest.
+*/
+
+// A few words, e.g. the word split between 2 chunks, or a short packet
+// header, cost less in the scalar kernel inline than in a SIMD call.
+
+#define ADLER_UPDATE_SHORT 8 // words
+
+GCC_ATTRIB(nothrow,nonnull)
+static void adlerUpdate32(AYBern_adlerHash32Ctx * ctx, const uint8_t * msg, size_t n)
+{
+  const uint32_t block_len = ADLER32_BLOCK_LEN;
+
+  while (n) {
+    uint32_t len = block_len - ctx->pos;
+    if (len > n) len = (uint32_t)n;
+
+    ctx->adler_sum += (len < ADLER_UPDATE_SHORT) ? adlerSum32_scalar(msg, len, ctx->pos)
+      : adler_kernel->sum32(msg, len, ctx->pos);
+    ctx->pos += len;
+    msg += 2*len;
+    n -= len;
+
+    if (ctx->pos == block_len) { // a full block: lcg_a = 1
+      ctx->hash_code = adlerChain32(ctx->hash_code, ctx->adler_sum, 1, ctx->j++);
+      ctx->adler_sum = 0;
+      ctx->pos = 0;
+    }
+  }
+}
+
+GCC_ATTRIB(nothrow,nonnull)
+static void adlerUpdate64(AYBern_adlerHash64Ctx * ctx, const uint8_t * msg, size_t n)
+{
+  const uint32_t block_len = ADLER64_BLOCK_LEN;
+
+  while (n) {
+    uint32_t len = block_len - ctx->pos;
+    if (len > n) len = (uint32_t)n;
+
+    ctx->adler_sum += (len < ADLER_UPDATE_SHORT) ? adlerSum64_scalar(msg, len, ctx->pos)
+      : adler_kernel->sum64(msg, len, ctx->pos);
+    ctx->pos += len;
+    msg += 4*len;
+    n -= len;
+
+    if (ctx->pos == block_len) { // a full block: lcg_a = 1
+      ctx->hash_code = adlerChain64(ctx->hash_code, ctx->adler_sum, 1, ctx->j++);
+      ctx->adler_sum = 0;
+      ctx->pos = 0;
+    }
+  }
+}
+
+GCC_ATTRIB(nothrow,nonnull)
+static void cipherUpdate64(AYBern_adlerHashCipherXorshift128_64Ctx * ctx, const uint8_t * msg, size_t n)
+{
+  const uint32_t block_len = ADLER64_BLOCK_LEN;
+
+  union {
+    uint64_t r64;
+    uint32_t r32[2];
+  } un;
+
+  while (n) {
+    uint32_t len = block_len - ctx->pos;
+    if (len > n) len = (uint32_t)n;
+
+    if (ctx->pos & 1) { // the 2nd half of the previous chunk's last draw
+      ctx->adler_sum += (uint64_t)(ctx->pos+1) * (uint64_t)(load32(msg) ^ ctx->r32_odd);
+      len = 1;
+    } else if (len > 1) { // the kernel only does whole draws
+      len &= ~UINT32_C(1);
+      ctx->adler_sum += cipherSum64(msg, len, ctx->pos, ctx->s);
+    } else { // a single word at an even pos: keep the 2nd half of its draw
+      un.r64 = Xoroshiro128Plus_next(ctx->s);
+      ctx->adler_sum += (uint64_t)(ctx->pos+1) * (uint64_t)(load32(msg) ^ un.r32[0]);
+      ctx->r32_odd = un.r32[1];
+    }
+
+    ctx->pos += len;
+    msg += 4*len;
+    n -= len;
+
+    if (ctx->pos == block_len) { // a full block: lcg_a = 1
+      ctx->hash_code = adlerChain64(ctx->hash_code, ctx->adler_sum, 1, ctx->j++);
+      ctx->adler_sum = 0;
+      ctx->pos = 0;
+    }
+  }
+}
+
+// update(): completes a word carried over in ctx->tail, feeds all the whole
+// words straight from the caller's buffer, and carries the rest in ctx->tail.
+
+#define ADLER_UPDATE_BYTES(ctx, data, n_bytes, word_size, update) \
+  do { \
+    const uint8_t * p = (const uint8_t *)(data); \
+    size_t n = (n_bytes); \
+    if (!n) break; /* data may be NULL */ \
+    if ((ctx)->tail_len) { /* complete the word carried over from the previous update */ \
+      while ((ctx)->tail_len < (word_size) && n) { \
+        (ctx)->tail[(ctx)->tail_len++] = *p++; \
+        --n; \
+      } \
+      if ((ctx)->tail_len < (word_size)) break; \
+      update((ctx), (ctx)->tail, 1); \
+      (ctx)->tail_len = 0; \
+    } \
+    update((ctx), p, n / (word_size)); \
+    p += n & ~(size_t)((word_size) - 1); \
+    n &= (word_size) - 1; \
+    memcpy((ctx)->tail, p, n); \
+    (ctx)->tail_len = (uint32_t)n; \
+  } while (0)
+
+// final(): pad a copy of the context with zero bytes to a word boundary
+
+#define ADLER_FINAL_PAD(ctx, copy, word_size, update) \
+  do { \
+    copy = *(ctx); \
+    if (copy.tail_len) { \
+      memset(copy.tail + copy.tail_len, 0, (word_size) - copy.tail_len); \
+      copy.tail_len = 0; \
+      update(&copy, copy.tail, 1); \
+    } \
+  } while (0)
+
+GCC_ATTRIB(nothrow,nonnull)
+void AYBern_adlerHash32Init(AYBern_adlerHash32Ctx * ctx)
+{
+  memset(ctx, 0, sizeof(*ctx));
+}
+
+GCC_ATTRIB(nothrow,nonnull(1))
+void AYBern_adlerHash32Update(AYBern_adlerHash32Ctx * ctx, const void * data, size_t n_bytes)
+{
+  ADLER_UPDATE_BYTES(ctx, data, n_bytes, 2, adlerUpdate32);
+}
+
+GCC_ATTRIB(nothrow,nonnull,pure)
+uint32_t AYBern_adlerHash32Final(const AYBern_adlerHash32Ctx * ctx)
+{
+  AYBern_adlerHash32Ctx c;
+  ADLER_FINAL_PAD(ctx, c, 2, adlerUpdate32);
+
+  if (c.pos == 0) return c.hash_code; // no partial last block
+
+  return adlerChain32(c.hash_code, c.adler_sum, adlerLcgA32(c.pos), c.j);
+}
+
+GCC_ATTRIB(nothrow,nonnull)
+void AYBern_adlerHash64Init(AYBern_adlerHash64Ctx * ctx)
+{
+  memset(ctx, 0, sizeof(*ctx));
+}
+
+GCC_ATTRIB(nothrow,nonnull(1))
+void AYBern_adlerHash64Update(AYBern_adlerHash64Ctx * ctx, const void * data, size_t n_bytes)
+{
+  ADLER_UPDATE_BYTES(ctx, data, n_bytes, 4, adlerUpdate64);
+}
+
+GCC_ATTRIB(nothrow,nonnull,pure)
+uint64_t AYBern_adlerHash64Final(const AYBern_adlerHash64Ctx * ctx)
+{
+  AYBern_adlerHash64Ctx c;
+  ADLER_FINAL_PAD(ctx, c, 4, adlerUpdate64);
+
+  if (c.pos == 0) return c.hash_code; // no partial last block
+
+  return adlerChain64(c.hash_code, c.adler_sum, adlerLcgA64(c.pos), c.j);
+}
+
+GCC_ATTRIB(nothrow,nonnull)
+void AYBern_adlerHashCipherXorshift128_64Init(AYBern_adlerHashCipherXorshift128_64Ctx * ctx,
+    const uint64_t iv[2], uint64_t seed)
+{
+  memset(ctx, 0, sizeof(*ctx));
+
+  // temper the iv
+  ctx->s[0] = SplitMix_next(iv[0]^seed);
+  ctx->s[1] = SplitMix_next(iv[1]);
+}
+
+GCC_ATTRIB(nothrow,nonnull(1))
+void AYBern_adlerHashCipherXorshift128_64Update(AYBern_adlerHashCipherXorshift128_64Ctx * ctx,
+    const void * data, size_t n_bytes)
+{
+  ADLER_UPDATE_BYTES(ctx, data, n_bytes, 4, cipherUpdate64);
+}
+
+GCC_ATTRIB(nothrow,nonnull,pure)
+uint64_t AYBern_adlerHashCipherXorshift128_64Final(const AYBern_adlerHashCipherXorshift128_64Ctx * ctx)
+{
+  AYBern_adlerHashCipherXorshift128_64Ctx c;
+  ADLER_FINAL_PAD(ctx, c, 4, cipherUpdate64);
+
+  if (c.pos == 0) return c.hash_code; // no partial last block
+
+  return adlerChain64(c.hash_code, c.adler_sum, adlerLcgA64(c.pos), c.j);
+}
+
+#undef ADLER_UPDATE_BYTES
+#undef ADLER_UPDATE_SHORT
+#undef ADLER_FINAL_PAD
+
+/*
+  MULTI-DIGEST
+
+  Several digests of the same message in one pass over memory: the legacy
+  Adler-32, hash32 and hash64, in any combination. The message is walked in
+  ADLER_MULTI_TILE byte tiles, and each requested digest's streaming update
+  runs over a tile while it is still in L1, so every cache line is read
+  from memory once, however many digests there are. The streaming contexts
+  keep each digest's own block geometry: 1K byte blocks for hash32, 512K
+  byte blocks for hash64, and the mod 65521 of Adler-32 every ZLIB_NMAX
+  bytes. A tile is a whole number of hash32 blocks and divides a hash64
+  block, so that it does not split a block more than the caller does.
+*/
+
+#define ADLER_MULTI_TILE 16384 // bytes: half of a 32K L1
+
+GCC_ATTRIB(nothrow,nonnull)
+void AYBern_adlerMultiInit(AYBern_adlerMultiCtx * ctx, unsigned which)
+{
+  memset(ctx, 0, sizeof(*ctx));
+  ctx->which = which;
+  ctx->adler32 = 1;
+  AYBern_adlerHash32Init(&ctx->h32);
+  AYBern_adlerHash64Init(&ctx->h64);
+}
+
+GCC_ATTRIB(nothrow,nonnull(1))
+void AYBern_adlerMultiUpdate(AYBern_adlerMultiCtx * ctx, const void * data, size_t n_bytes)
+{
+  const uint8_t * p = (const uint8_t *)data;
+
+  while (n_bytes) {
+    size_t len = (n_bytes < ADLER_MULTI_TILE) ? n_bytes : ADLER_MULTI_TILE;
+
+    if (ctx->which & AYBERN_DIGEST_ADLER32) ctx->adler32 = adler_kernel->zlib_adler32(ctx->adler32, p, len);
+    if (ctx->which & AYBERN_DIGEST_HASH32) AYBern_adlerHash32Update(&ctx->h32, p, len);
+    if (ctx->which & AYBERN_DIGEST_HASH64) AYBern_adlerHash64Update(&ctx->h64, p, len);
+
+    p += len;
+    n_bytes -= len;
+  }
+}
+
+GCC_ATTRIB(nothrow,nonnull)
+void AYBern_adlerMultiFinal(const AYBern_adlerMultiCtx * ctx, AYBern_adlerMultiDigest * digest)
+{
+  memset(digest, 0, sizeof(*digest));
+
+  if (ctx->which & AYBERN_DIGEST_ADLER32) digest->adler32 = ctx->adler32;
+  if (ctx->which & AYBERN_DIGEST_HASH32) digest->hash32 = AYBern_adlerHash32Final(&ctx->h32);
+  if (ctx->which & AYBERN_DIGEST_HASH64) digest->hash64 = AYBern_adlerHash64Final(&ctx->h64);
+}
+
+GCC_ATTRIB(nothrow,nonnull)
+void AYBern_adlerMultiDigestMem(const void * msg, size_t n_bytes, unsigned which, AYBern_adlerMultiDigest * digest)
+{
+  AYBern_adlerMultiCtx ctx;
+
+  AYBern_adlerMultiInit(&ctx, which);
+  AYBern_adlerMultiUpdate(&ctx, msg, n_bytes);
+  AYBern_adlerMultiFinal(&ctx, digest);
+}
+
+/*
+  SCATTER-GATHER
+
+  The digest of a message which is scattered over several buffers, e.g. a
+  packet's header and payload fragments, or a record which wraps around a
+  ring buffer: exactly the digest of the concatenation of the segments,
+  without copying them into one. Each segment is just a streaming update,
+  which carries the word position, the block boundary and a word split
+  between 2 segments over to the next one, so the SIMD kernels still run
+  straight from the caller's buffers. Empty segments are skipped, and their
+  iov_base may be NULL.
+*/
+
+#define ADLER_HASHV(ctx, iov, iovcnt, update) \
+  do { \
+    for (size_t v = 0; v < (iovcnt); ++v) { \
+      if ((iov)[v].iov_len) update((ctx), (iov)[v].iov_base, (iov)[v].iov_len); \
+    } \
+  } while (0)
+
+GCC_ATTRIB(nothrow,nonnull(2),pure)
+uint32_t AYBern_adler32Zlibv(uint32_t adler, const struct iovec * iov, size_t iovcnt)
+{
+  for (size_t v = 0; v < iovcnt; ++v) {
+    if (iov[v].iov_len) adler = adler_kernel->zlib_adler32(adler, (const uint8_t *)iov[v].iov_base, iov[v].iov_len);
+  }
+
+  return adler;
+}
+
+GCC_ATTRIB(nothrow,nonnull,pure)
+uint32_t AYBern_adlerHash32v(const struct iovec * iov, size_t iovcnt)
+{
+  AYBern_adlerHash32Ctx ctx;
+
+  AYBern_adlerHash32Init(&ctx);
+  ADLER_HASHV(&ctx, iov, iovcnt, AYBern_adlerHash32Update);
+  return AYBern_adlerHash32Final(&ctx);
+}
+
+GCC_ATTRIB(nothrow,nonnull,pure)
+uint64_t AYBern_adlerHash64v(const struct iovec * iov, size_t iovcnt)
+{
+  AYBern_adlerHash64Ctx ctx;
+
+  AYBern_adlerHash64Init(&ctx);
+  ADLER_HASHV(&ctx, iov, iovcnt, AYBern_adlerHash64Update);
+  return AYBern_adlerHash64Final(&ctx);
+}
+
+GCC_ATTRIB(nothrow,nonnull,pure)
+uint64_t AYBern_adlerHashCipherXorshift128_64v(const struct iovec * iov, size_t iovcnt,
+    const uint64_t iv[2], uint64_t seed)
+{
+  AYBern_adlerHashCipherXorshift128_64Ctx ctx;
+
+  AYBern_adlerHashCipherXorshift128_64Init(&ctx, iv, seed);
+  ADLER_HASHV(&ctx, iov, iovcnt, AYBern_adlerHashCipherXorshift128_64Update);
+  return AYBern_adlerHashCipherXorshift128_64Final(&ctx);
+}
+
+#undef ADLER_HASHV
+
+/*
+  THREAD POOL
+
+  A persistent pool of worker threads which runs "parallel for" jobs over a
+  range of items. The calling thread works on the job too, so a pool of
+  n_threads has n_threads - 1 workers. Items are handed out one at a time
+  under the pool mutex, which is cheap since every item is at least 64K bytes
+  of hashing. Concurrent callers of the same pool are serialized.
+*/
+
+struct AYBern_ThreadPool {
+  pthread_mutex_t run_mutex; // one job at a time
+  pthread_mutex_t mutex; // protects everything below
+  pthread_cond_t work_cv; // a new job or shutdown
+  pthread_cond_t done_cv; // all the items of the job are done
+  unsigned n_threads; // including the caller
+  unsigned n_workers;
+  pthread_t * workers;
+  int shutdown;
+  uint32_t generation; // incremented for every job
+  void (*fn)(void * arg, uint32_t item);
+  void * arg;
+  uint32_t n_items;
+  uint32_t next_item;
+  uint32_t n_done;
+};
+
+// Called with pool->mutex held. Works on items until none are left.
+
+GCC_ATTRIB(nothrow,nonnull)
+static void threadPoolDrain(AYBern_ThreadPool * pool)
+{
+  while (pool->next_item < pool->n_items) {
+    uint32_t item = pool->next_item++;
+
+    pthread_mutex_unlock(&pool->mutex);
+    pool->fn(pool->arg, item);
+    pthread_mutex_lock(&pool->mutex);
+
+    if (++pool->n_done == pool->n_items) pthread_cond_signal(&pool->done_cv);
+  }
+}
+
+GCC_ATTRIB(nothrow,nonnull)
+static void * threadPoolWorker(void * arg)
+{
+  AYBern_ThreadPool * pool = (AYBern_ThreadPool *)arg;
+  uint32_t generation = 0;
+
+  pthread_mutex_lock(&pool->mutex);
+
+  for (;;) {
+    while (!pool->shutdown && pool->generation == generation) {
+      pthread_cond_wait(&pool->work_cv, &pool->mutex);
+    }
+    if (pool->shutdown) break;
+
+    generation = pool->generation;
+    threadPoolDrain(pool);
+  }
+
+  pthread_mutex_unlock(&pool->mutex);
+
+  return NULL;
+}
+
+GCC_ATTRIB(nothrow,nonnull(1,2))
+static void threadPoolRun(AYBern_ThreadPool * pool, void (*fn)(void * arg, uint32_t item), void * arg, uint32_t n_items)
+{
+  pthread_mutex_lock(&pool->run_mutex);
+  pthread_mutex_lock(&pool->mutex);
+
+  pool->fn = fn;
+  pool->arg = arg;
+  pool->n_items = n_items;
+  pool->next_item = 0;
+  pool->n_done = 0;
+  ++pool->generation;
+  pthread_cond_broadcast(&pool->work_cv);
+
+  threadPoolDrain(pool);
+
+  while (pool->n_done < pool->n_items) {
+    pthread_cond_wait(&pool->done_cv, &pool->mutex);
+  }
+
+  pthread_mutex_unlock(&pool->mutex);
+  pthread_mutex_unlock(&pool->run_mutex);
+}
+
+GCC_ATTRIB(nothrow)
+AYBern_ThreadPool * AYBern_threadPoolCreate(unsigned n_threads)
+{
+  if (n_threads == 0) {
+    long n_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    n_threads = (n_cpus > 0) ? (unsigned)n_cpus : 1;
+  }
+
+  AYBern_ThreadPool * pool = (AYBern_ThreadPool *)calloc(1, sizeof(AYBern_ThreadPool));
+  if (!pool) return NULL;
+
+  pool->n_threads = n_threads;
+  pool->workers = (pthread_t *)calloc(n_threads, sizeof(pthread_t));
+  if (!pool->workers) {
+    free(pool);
+    return NULL;
+  }
+
+  pthread_mutex_init(&pool->run_mutex, NULL);
+  pthread_mutex_init(&pool->mutex, NULL);
+  pthread_cond_init(&pool->work_cv, NULL);
+  pthread_cond_init(&pool->done_cv, NULL);
+
+  for (; pool->n_workers < n_threads - 1; ++pool->n_workers) {
+    if (pthread_create(&pool->workers[pool->n_workers], NULL, threadPoolWorker, pool) != 0) {
+      AYBern_threadPoolDestroy(pool);
+      return NULL;
+    }
+  }
+
+  return pool;
+}
+
+GCC_ATTRIB(nothrow)
+void AYBern_threadPoolDestroy(AYBern_ThreadPool * pool)
+{
+  if (!pool) return;
+
+  pthread_mutex_lock(&pool->mutex);
+  pool->shutdown = 1;
+  pthread_cond_broadcast(&pool->work_cv);
+  pthread_mutex_unlock(&pool->mutex);
+
+  for (unsigned i = 0; i < pool->n_workers; ++i) {
+    pthread_join(pool->workers[i], NULL);
+  }
+
+  pthread_cond_destroy(&pool->done_cv);
+  pthread_cond_destroy(&pool->work_cv);
+  pthread_mutex_destroy(&pool->mutex);
+  pthread_mutex_destroy(&pool->run_mutex);
+  free(pool->workers);
+  free(pool);
+}
+
+GCC_ATTRIB(nothrow,nonnull,pure)
+unsigned AYBern_threadPoolSize(const AYBern_ThreadPool * pool)
+{
+  return pool->n_threads;
+}
+
+/*
+  PARALLEL HASHING
+
+  The block sums are computed by the pool one window at a time, and then the
+  calling thread chains the window's sums in block order. A window holds
+  ADLER_WINDOW_ITEMS work items per thread, so that memory stays O(threads)
+  rather than O(message), while the threads still have enough items to
+  balance the load. A hash64 work item is 1 block (512K bytes). A hash32 work
+  item is ADLER32_ITEM_BLOCKS blocks (64K bytes), because a 1K byte block is
+  far too small to be worth a trip through the pool.
+
+  The cipher variant is parallel too, since every whole block takes exactly
+  2^16 draws from the PRNG: the calling thread jumps the tempered state ahead
+  from block to block with Xoroshiro128Plus_jump(), which is ~128 steps
+  instead of 2^16, and hands each item its block's starting state.
+*/
+
+#define ADLER_WINDOW_ITEMS 4 // per thread
+#define ADLER32_ITEM_BLOCKS 64
+
+typedef struct {
+  const uint8_t * msg; // first byte of the window
+  size_t n_bytes; // bytes in the window, the last block may be partial
+  void * sums; // one per block of the window
+  uint64_t (*states)[2]; // cipher only: the PRNG state at the start of each block
+} AdlerSumJob;
+
+GCC_ATTRIB(nothrow,nonnull)
+static void adlerSum32Item(void * arg, uint32_t item)
+{
+  const AdlerSumJob * job = (const AdlerSumJob *)arg;
+  const size_t block_bytes = 2*ADLER32_BLOCK_LEN;
+  uint32_t * sums = (uint32_t *)job->sums;
+
+  for (uint32_t b = item * ADLER32_ITEM_BLOCKS; b < (item + 1) * ADLER32_ITEM_BLOCKS; ++b) {
+    size_t k = b * block_bytes;
+    if (k >= job->n_bytes) break;
+    uint32_t bytes = (job->n_bytes - k < block_bytes) ? (uint32_t)(job->n_bytes - k) : block_bytes;
+    sums[b] = adlerBlockSum32(job->msg + k, bytes/2 + (bytes & 1), bytes & 1);
+  }
+}
+
+GCC_ATTRIB(nothrow,nonnull)
+static void adlerSum64Item(void * arg, uint32_t item)
+{
+  const AdlerSumJob * job = (const AdlerSumJob *)arg;
+  const size_t block_bytes = 4*ADLER64_BLOCK_LEN;
+  uint64_t * sums = (uint64_t *)job->sums;
+
+  size_t k = item * block_bytes;
+  uint32_t bytes = (job->n_bytes - k < block_bytes) ? (uint32_t)(job->n_bytes - k) : block_bytes;
+  sums[item] = adlerBlockSum64(job->msg + k, bytes/4 + ((bytes & 3) != 0), bytes & 3);
+}
+
+GCC_ATTRIB(nothrow,nonnull)
+static void cipherSum64Item(void * arg, uint32_t item)
+{
+  const AdlerSumJob * job = (const AdlerSumJob *)arg;
+  const size_t block_bytes = 4*ADLER64_BLOCK_LEN;
+  uint64_t * sums = (uint64_t *)job->sums;
+
+  size_t k = item * block_bytes;
+  uint32_t bytes = (job->n_bytes - k < block_bytes) ? (uint32_t)(job->n_bytes - k) : block_bytes;
+  Xoroshiro128Plus_State st = { { job->states[item][0], job->states[item][1] } };
+  sums[item] = cipherSum_Xoroshiro128Plus(job->msg + k, bytes/4 + ((bytes & 3) != 0), 0, &st, bytes & 3);
+}
+
+GCC_ATTRIB(nothrow,nonnull(2))
+uint32_t AYBern_adlerHash32MemParallel(AYBern_ThreadPool * pool, const void * msg, size_t n_bytes)
+{
+  const uint32_t block_len = ADLER32_BLOCK_LEN;
+  const size_t block_bytes = 2*(size_t)block_len;
+
+  size_t n = n_bytes/2 + (n_bytes & 1); // including the padded tail word
+
+  uint64_t n_blocks = n/block_len;
+  uint32_t last_block_len = n & (block_len-1);
+  if (last_block_len) ++n_blocks;
+
+  if (!pool || pool->n_threads < 2 || n_blocks < 2 * ADLER32_ITEM_BLOCKS) {
+    return adlerHash32((const uint8_t *)msg, n_bytes);
+  }
 
-  // GOTCHYA: since our block sizes are 2^N by design, when we report that the
-  // last_block_len is zero, in fact it means that it is full size,
-  // i.e. block_len !
+  const uint32_t window_items = ADLER_WINDOW_ITEMS * pool->n_threads;
+  const uint32_t window_blocks = window_items * ADLER32_ITEM_BLOCKS;
 
-  const uint32_t lcg_c = 1013904223; // Numerical Recipes lcg32 prime > max(lcg_a)
-  uint32_t lcg_a = 1;
-  // all blocks except the last, are by definition full size so their lcg_a = 1
-  uint32_t last_lcg_a = lcg_a;
-  if (last_block_len) {
-    last_lcg_a = (1 << shift)/(last_block_len * (last_block_len + 1));
-    // satisfy Hull-Dobell multiplier constraint
-    uint32_t hd_remainder = (last_lcg_a - 1) & 3;
-    if (hd_remainder) last_lcg_a -= hd_remainder;
-  }
+  uint32_t * sums = (uint32_t *)malloc(window_blocks * sizeof(uint32_t));
+  if (!sums) return adlerHash32((const uint8_t *)msg, n_bytes);
 
-  uint32_t i,j,k;
+  uint32_t hash_code = 0;
+  uint64_t j = 0;
 
-  for (j=0, k=0; j < n_blocks; ++j, k+=block_len) { // block loop: begin
+  while (j < n_blocks) { // window loop: begin
+    uint32_t w_blocks = (n_blocks - j < window_blocks) ? (uint32_t)(n_blocks - j) : window_blocks;
+    size_t k = j * block_bytes;
 
-    if (j == (n_blocks - 1)) {
-      if (last_block_len) {
-        len = last_block_len;
-        lcg_a = last_lcg_a;
-      }
-    } // otherwise it is a full size block
+    AdlerSumJob job;
+    job.msg = (const uint8_t *)msg + k;
+    job.n_bytes = (n_bytes - k < w_blocks * block_bytes) ? n_bytes - k : w_blocks * block_bytes;
+    job.sums = sums;
 
-    uint32_t adler_sum = 0;
+    threadPoolRun(pool, adlerSum32Item, &job, (w_blocks + ADLER32_ITEM_BLOCKS - 1) / ADLER32_ITEM_BLOCKS);
 
-    for (i = 0; i < len; ++i) {
-        adler_sum += (i+1) * msg[i+k]; // retain original adler32 speed and simplicity
+    for (uint32_t b = 0; b < w_blocks; ++b, ++j) {
+      uint32_t lcg_a = (j == n_blocks - 1 && last_block_len) ? adlerLcgA32(last_block_len) : 1;
+      hash_code = adlerChain32(hash_code, sums[b], lcg_a, j);
     }
+  } // window loop: end
 
-    // lcg: params selected to evenly spread the bits over the whole 2^32 space
+  free(sums);
 
-    uint32_t lcg = lcg_c;
-    if (lcg_a == 1) {
-        lcg += adler_sum;
-    } else {
-        lcg += adler_sum * lcg_a; // spread the bits for smaller block sizes
-    }
+  return hash_code;
+}
 
-    // block chain with order dependencies
+GCC_ATTRIB(nothrow,nonnull(2))
+uint64_t AYBern_adlerHash64MemParallel(AYBern_ThreadPool * pool, const void * msg, size_t n_bytes)
+{
+  const uint32_t block_len = ADLER64_BLOCK_LEN;
+  const size_t block_bytes = 4*(size_t)block_len;
 
-    hash_code ^= (j & 1) ? ~lcg : lcg; // block order dependency by using j
+  size_t n = n_bytes/4 + ((n_bytes & 3) != 0); // including the padded tail word
 
-    // mix: "roll my own" mixer because SplitMix doesn't handle 32 bits
+  uint64_t n_blocks = n/block_len;
+  uint32_t last_block_len = n & (block_len-1);
+  if (last_block_len) ++n_blocks;
 
-    // 1. Gray xform
+  if (!pool || pool->n_threads < 2 || n_blocks < 2) {
+    return adlerHash64((const uint8_t *)msg, n_bytes);
+  }
 
-    hash_code ^= hash_code >> 1;
+  const uint32_t window_blocks = ADLER_WINDOW_ITEMS * pool->n_threads;
 
-    // 2. double Rivest DDR
+  uint64_t * sums = (uint64_t *)malloc(window_blocks * sizeof(uint64_t));
+  if (!sums) return adlerHash64((const uint8_t *)msg, n_bytes);
 
-    uint16_t lo = hash_code & 0xffff;
-    uint16_t hi = hash_code >> 16;
+  uint64_t hash_code = 0;
+  uint64_t j = 0;
 
-    uint16_t lo_shift = (hi + (uint16_t)j) & 0xf; // block order dependency by using j
-    uint16_t hi_shift = (lo + (uint16_t)~j) & 0xf; // block order dependency by using j
+  while (j < n_blocks) { // window loop: begin
+    uint32_t w_blocks = (n_blocks - j < window_blocks) ? (uint32_t)(n_blocks - j) : window_blocks;
+    size_t k = j * block_bytes;
 
-    hi = rotl16(hi, (int16_t)hi_shift);
-    lo = rotl16(lo, (int16_t)lo_shift);
+    AdlerSumJob job;
+    job.msg = (const uint8_t *)msg + k;
+    job.n_bytes = (n_bytes - k < w_blocks * block_bytes) ? n_bytes - k : w_blocks * block_bytes;
+    job.sums = sums;
 
-    // put humpty dumpty back together again
+    threadPoolRun(pool, adlerSum64Item, &job, w_blocks);
 
-    hash_code = (uint32_t)lo | (uint32_t)(hi << 16);
-  } // block loop: end
+    for (uint32_t b = 0; b < w_blocks; ++b, ++j) {
+      uint64_t lcg_a = (j == n_blocks - 1 && last_block_len) ? adlerLcgA64(last_block_len) : 1;
+      hash_code = adlerChain64(hash_code, sums[b], lcg_a, j);
+    }
+  } // window loop: end
+
+  free(sums);
 
   return hash_code;
 }
 
-GCC_ATTRIB(nothrow,nonnull,pure)
-uint64_t AYBern_adlerHash64(const uint32_t * msg, uint32_t n)
+GCC_ATTRIB(nothrow,nonnull(2,4))
+uint64_t AYBern_adlerHashCipherXorshift128_64MemParallel(AYBern_ThreadPool * pool, const void * msg, size_t n_bytes,
+    const uint64_t iv[2], uint64_t seed)
 {
-  uint64_t hash_code = 0;
+  const uint32_t block_len = ADLER64_BLOCK_LEN;
+  const size_t block_bytes = 4*(size_t)block_len;
+  const uint64_t jump[2] = XOROSHIRO128_JUMP_2_16;
 
-  const int32_t shift = 35; // 65 - 6 - 8 - 16
-  const uint32_t block_len = 1 << (shift >> 1); // 2^17 uint32_t = 2^19 bytes = 512K bytes
+  size_t n = n_bytes/4 + ((n_bytes & 3) != 0); // including the padded tail word
 
-  uint32_t len = block_len;
-  uint32_t n_blocks = n/block_len;
+  uint64_t n_blocks = n/block_len;
   uint32_t last_block_len = n & (block_len-1);
   if (last_block_len) ++n_blocks;
 
-  // GOTCHYA: since our block sizes are 2^N by design, when we report that the
-  // last_block_len is zero, in fact it means that it is full size,
-  // i.e. block_len !
-
-  const uint64_t lcg_c = UINT64_C(1442695040888963407); // Knuth lcg64. It is not prime
-  uint64_t lcg_a = 1;
-  uint64_t last_lcg_a = lcg_a;
-  // all blocks except the last, are by definition full size so their lcg_a = 1
-  if (last_block_len) {
-    last_lcg_a = (UINT64_C(1) << shift)/((uint64_t)last_block_len * (last_block_len + 1));
-    // satisfy Hull-Dobell multiplier constraint
-    uint64_t hd_remainder = (last_lcg_a - 1) & 3;
-    if (hd_remainder) last_lcg_a -= hd_remainder;
+  if (!pool || pool->n_threads < 2 || n_blocks < 2) {
+    return cipherHash64((const uint8_t *)msg, n_bytes, iv, seed);
   }
 
-  uint32_t i,j,k;
+  const uint32_t window_blocks = ADLER_WINDOW_ITEMS * pool->n_threads;
 
-  for (j=0, k=0; j < n_blocks; ++j, k+=block_len) { // block loop: begin
+  uint64_t * sums = (uint64_t *)malloc(window_blocks * sizeof(uint64_t));
+  uint64_t (*states)[2] = (uint64_t (*)[2])malloc(window_blocks * sizeof(*states));
+  if (!sums || !states) {
+    free(sums);
+    free(states);
+    return cipherHash64((const uint8_t *)msg, n_bytes, iv, seed);
+  }
 
-    if (j == (n_blocks - 1)) {
-      if (last_block_len) {
-        len = last_block_len;
-        lcg_a = last_lcg_a;
-      }
-    } // otherwise it is a full size block
+  // temper the iv
+  uint64_t s[2] = { SplitMix_next(iv[0]^seed), SplitMix_next(iv[1]) };
+
+  uint64_t hash_code = 0;
+  uint64_t j = 0;
 
-    uint64_t adler_sum = 0;
+  while (j < n_blocks) { // window loop: begin
+    uint32_t w_blocks = (n_blocks - j < window_blocks) ? (uint32_t)(n_blocks - j) : window_blocks;
+    size_t k = j * block_bytes;
 
-    for (i = 0; i < len; ++i) {
-      adler_sum += (uint64_t)(i+1) * (uint64_t)msg[i+k]; // retain original adler32 speed and simplicity
+    for (uint32_t b = 0; b < w_blocks; ++b) {
+      states[b][0] = s[0];
+      states[b][1] = s[1];
+      Xoroshiro128Plus_jump(s, jump); // the start of the next block
     }
 
-    // lcg: params selected to evenly spread the bits over the whole 2^64 space
+    AdlerSumJob job;
+    job.msg = (const uint8_t *)msg + k;
+    job.n_bytes = (n_bytes - k < w_blocks * block_bytes) ? n_bytes - k : w_blocks * block_bytes;
+    job.sums = sums;
+    job.states = states;
 
-    uint64_t lcg = lcg_c;
-    if (lcg_a == UINT64_C(1)) {
-        lcg += adler_sum;
-    } else {
-        lcg += adler_sum * lcg_a; // spread the bits for smaller block sizes
+    threadPoolRun(pool, cipherSum64Item, &job, w_blocks);
+
+    for (uint32_t b = 0; b < w_blocks; ++b, ++j) {
+      uint64_t lcg_a = (j == n_blocks - 1 && last_block_len) ? adlerLcgA64(last_block_len) : 1;
+      hash_code = adlerChain64(hash_code, sums[b], lcg_a, j);
     }
+  } // window loop: end
 
-    // block chain with order dependencies
+  free(states);
+  free(sums);
 
-    hash_code ^= lcg;
+  return hash_code;
+}
 
-    // mix: SplitMix is a fanatastic mixer - without being heavy
+GCC_ATTRIB(nothrow,nonnull(2))
+uint32_t AYBern_adlerHash32Parallel(AYBern_ThreadPool * pool, const uint16_t * msg, uint32_t n)
+{
+  return AYBern_adlerHash32MemParallel(pool, msg, 2*(size_t)n);
+}
 
-    hash_code = SplitMix_next(hash_code + (uint64_t)j); // block order dependency by using j
-  } // block loop: end
+GCC_ATTRIB(nothrow,nonnull(2))
+uint64_t AYBern_adlerHash64Parallel(AYBern_ThreadPool * pool, const uint32_t * msg, uint32_t n)
+{
+  return AYBern_adlerHash64MemParallel(pool, msg, 4*(size_t)n);
+}
 
-  return hash_code;
+GCC_ATTRIB(nothrow,nonnull(2,4))
+uint64_t AYBern_adlerHashCipherXorshift128_64Parallel(AYBern_ThreadPool * pool, const uint32_t * msg, uint32_t n,
+    const uint64_t iv[2], uint64_t seed)
+{
+  return AYBern_adlerHashCipherXorshift128_64MemParallel(pool, msg, 4*(size_t)n, iv, seed);
 }
 
+/*
+  STRIDED 2D
+
+  The digest of a 2D region, e.g. an image tile or a matrix sub-block,
+  which is rows of row_bytes at a distance of stride bytes, without
+  gathering it into a scratch buffer: exactly the digest of the gathered
+  rows. Every row is a streaming update, which carries the word position
+  and the block boundary over to the next row, and the SIMD kernels run
+  straight from the rows.
+
+  The tile grid hashes every tile of a frame, in 1 pass over the frame in
+  memory order: a work item is a band of tile_rows rows, which is walked
+  row by row, and each row updates the contexts of the tiles that it
+  crosses, one kernel call per tile row. The bands are independent, so a
+  pool runs them in parallel. The tiles at the right and bottom edges are
+  partial if the frame is not a whole number of tiles.
+
+  The usual tile, whole words wide and at most 1 block, takes a fast path:
+  the kernel sums each tile row straight into the tile's block sum, at word
+  position row * tile_words, without the contexts' byte handling, which
+  would otherwise cost more than the sum of a short tile row.
+*/
+
+#define ADLER_STRIDED(ctx, base, row_bytes, stride, rows, update) \
+  do { \
+    const uint8_t * row = (const uint8_t *)(base); \
+    if (row_bytes) { \
+      for (size_t r = 0; r < (rows); ++r, row += (stride)) update((ctx), row, (row_bytes)); \
+    } \
+  } while (0)
+
 GCC_ATTRIB(nothrow,nonnull,pure)
-uint64_t AYBern_adlerHashCipherXorshift128_64(const uint32_t * msg, uint32_t n, const uint64_t iv[2], uint64_t seed)
+uint32_t AYBern_adlerHash32Strided(const void * base, size_t row_bytes, size_t stride, size_t rows)
 {
-  uint64_t hash_code = 0;
+  if (row_bytes == stride) return adlerHash32((const uint8_t *)base, row_bytes * rows); // contiguous
 
-  const int32_t shift = 35; // 65 - 6 - 8 - 16
-  const uint32_t block_len = 1 << (shift >> 1); // 2^17 uint32_t = 2^19 bytes = 512K bytes
+  AYBern_adlerHash32Ctx ctx;
 
-  uint32_t len = block_len;
-  uint32_t n_blocks = n/block_len;
-  uint32_t last_block_len = n & (block_len-1);
-  if (last_block_len) ++n_blocks;
+  AYBern_adlerHash32Init(&ctx);
+  ADLER_STRIDED(&ctx, base, row_bytes, stride, rows, AYBern_adlerHash32Update);
+  return AYBern_adlerHash32Final(&ctx);
+}
 
-  const uint64_t lcg_c = UINT64_C(1442695040888963407); // Knuth lcg64. It is not prime
-  uint64_t lcg_a = 1;
-  uint64_t last_lcg_a = lcg_a;
-  if (last_block_len) {
-    last_lcg_a = (UINT64_C(1) << shift)/((uint64_t)last_block_len * (last_block_len + 1));
-    // satisfy Hull-Dobell multiplier constraint
-    uint64_t hd_remainder = (last_lcg_a - 1) & 3;
-    if (hd_remainder) last_lcg_a -= hd_remainder;
-  }
+GCC_ATTRIB(nothrow,nonnull,pure)
+uint64_t AYBern_adlerHash64Strided(const void * base, size_t row_bytes, size_t stride, size_t rows)
+{
+  if (row_bytes == stride) return adlerHash64((const uint8_t *)base, row_bytes * rows); // contiguous
 
-  // temper the iv
-  uint64_t s[2] = { SplitMix_next(iv[0]^seed), SplitMix_next(iv[1]) };
+  AYBern_adlerHash64Ctx ctx;
 
-  union {
-    uint64_t r64;
-    uint32_t r32[2];
-  } un;
+  AYBern_adlerHash64Init(&ctx);
+  ADLER_STRIDED(&ctx, base, row_bytes, stride, rows, AYBern_adlerHash64Update);
+  return AYBern_adlerHash64Final(&ctx);
+}
 
-  uint32_t i,j,k;
+#undef ADLER_STRIDED
 
-  for (k=0, j=0; j < n_blocks; ++j, k+=block_len) { // block loop: begin
+typedef struct {
+  const uint8_t * base;
+  size_t width_bytes, height, stride;
+  size_t tile_bytes, tile_rows;
+  size_t tiles_x;
+  AYBern_adlerHash64Ctx * ctx; // tiles_x per band
+  uint64_t * sums; // fast path: tiles_x block sums per band, instead of ctx
+  uint64_t * digests;
+} AdlerTileJob;
 
-    if (j == (n_blocks - 1)) {
-      if (last_block_len) {
-        len = last_block_len;
-        lcg_a = last_lcg_a;
-      }
-    }
+GCC_ATTRIB(nothrow,nonnull)
+static void adlerTileBandItem(void * arg, uint32_t item)
+{
+  const AdlerTileJob * job = (const AdlerTileJob *)arg;
 
-    uint32_t parity = 1;
+  size_t y0 = item * job->tile_rows;
+  size_t y1 = (job->height - y0 < job->tile_rows) ? job->height : y0 + job->tile_rows;
 
-    uint64_t adler_sum = 0;
+  if (job->sums) { // fast path
+    uint64_t * sums = job->sums + item * job->tiles_x;
+    for (size_t t = 0; t < job->tiles_x; ++t) sums[t] = 0;
 
-    for (i = 0; i < len; ++i) {
-      parity = 1 - parity;
+    for (size_t y = y0; y < y1; ++y) { // row loop: begin
+      const uint8_t * row = job->base + y * job->stride;
 
-      if (parity == 0) {
-        un.r64 = Xoroshiro128Plus_next(s); // prepare 64-bit mask from PRNG to be used similar to a stream cipher
+      for (size_t t = 0, x = 0; t < job->tiles_x; ++t, x += job->tile_bytes) {
+        size_t len = (job->width_bytes - x < job->tile_bytes) ? job->width_bytes - x : job->tile_bytes;
+        uint32_t words = (uint32_t)(len / 4);
+        sums[t] += adler_kernel->sum64(row + x, words, words * (uint32_t)(y - y0));
       }
+    } // row loop: end
 
-      adler_sum += (uint64_t)(i+1) * (uint64_t)(msg[i+k] ^ un.r32[parity]); // apply PRNG mask 32 bits at a time
+    for (size_t t = 0, x = 0; t < job->tiles_x; ++t, x += job->tile_bytes) {
+      size_t len = (job->width_bytes - x < job->tile_bytes) ? job->width_bytes - x : job->tile_bytes;
+      uint32_t n_words = (uint32_t)(len / 4 * (y1 - y0));
+      job->digests[item * job->tiles_x + t] = adlerChain64(0, sums[t], adlerLcgA64(n_words), 0);
     }
+    return;
+  }
 
-    // lcg
+  AYBern_adlerHash64Ctx * ctx = job->ctx + item * job->tiles_x;
 
-    uint64_t lcg = lcg_c;
-    if (lcg_a == UINT64_C(1)) {
-        lcg += adler_sum;
-    } else {
-        lcg += adler_sum * lcg_a;
+  for (size_t t = 0; t < job->tiles_x; ++t) AYBern_adlerHash64Init(&ctx[t]);
+
+  for (size_t y = y0; y < y1; ++y) { // row loop: begin
+    const uint8_t * row = job->base + y * job->stride;
+
+    for (size_t t = 0, x = 0; t < job->tiles_x; ++t, x += job->tile_bytes) {
+      size_t len = (job->width_bytes - x < job->tile_bytes) ? job->width_bytes - x : job->tile_bytes;
+      AYBern_adlerHash64Update(&ctx[t], row + x, len);
     }
+  } // row loop: end
 
-    // block chain
+  for (size_t t = 0; t < job->tiles_x; ++t) {
+    job->digests[item * job->tiles_x + t] = AYBern_adlerHash64Final(&ctx[t]);
+  }
+}
 
-    hash_code ^= lcg;
+GCC_ATTRIB(nothrow,nonnull(2,8))
+int AYBern_adlerHash64TileGrid(AYBern_ThreadPool * pool, const void * base, size_t width_bytes, size_t height,
+    size_t stride, size_t tile_bytes, size_t tile_rows, uint64_t * digests)
+{
+  if (!tile_bytes || !tile_rows || width_bytes > stride) return -1;
+  if (!width_bytes || !height) return 0; // no tiles
+
+  size_t tiles_x = (width_bytes + tile_bytes - 1) / tile_bytes;
+  size_t tiles_y = (height + tile_rows - 1) / tile_rows;
+  if (tiles_y > UINT32_MAX) return -1;
+
+  AdlerTileJob job;
+  job.base = (const uint8_t *)base;
+  job.width_bytes = width_bytes;
+  job.height = height;
+  job.stride = stride;
+  job.tile_bytes = tile_bytes;
+  job.tile_rows = tile_rows;
+  job.tiles_x = tiles_x;
+  job.digests = digests;
+  job.ctx = NULL;
+  job.sums = NULL;
+  if (!(tile_bytes & 3) && !(width_bytes & 3) && tile_bytes / 4 * tile_rows <= ADLER64_BLOCK_LEN) {
+    job.sums = (uint64_t *)malloc(tiles_x * tiles_y * sizeof(uint64_t));
+    if (!job.sums) return -1;
+  } else {
+    job.ctx = (AYBern_adlerHash64Ctx *)malloc(tiles_x * tiles_y * sizeof(AYBern_adlerHash64Ctx));
+    if (!job.ctx) return -1;
+  }
 
-    // mix
+  if (pool && pool->n_threads > 1 && tiles_y > 1) {
+    threadPoolRun(pool, adlerTileBandItem, &job, (uint32_t)tiles_y);
+  } else {
+    for (uint32_t b = 0; b < tiles_y; ++b) adlerTileBandItem(&job, b);
+  }
 
-    hash_code = SplitMix_next(hash_code + (uint64_t)j); // block order dependency by using j
-  } // block loop: end
+  free(job.sums);
+  free(job.ctx);
 
-  return hash_code;
+  return 0;
 }
 
 #ifdef TEST
@@ -454,6 +4556,47 @@ uint64_t AYBern_adlerHashCipherXorshift128_64(const uint32_t * msg, uint32_t n,
 #include <stdlib.h>
 #include <string.h>
 
+// Quality check: the avalanche of 512 single bit flips, evenly spread over
+// an n_bytes message, in each of 16 pseudo random messages. It prints the
+// mean number of digest bits that flip, ideally 32, and the lowest and the
+// highest flip rate of any digest bit, ideally 0.5.
+
+static void testAvalanche64(const char * name, uint64_t (*hash)(const void *, size_t), size_t n_bytes)
+{
+  enum { MSGS = 16, FLIPS = 512 };
+  const size_t stride = 8*n_bytes/FLIPS; // bits
+
+  uint8_t * msg = malloc(n_bytes);
+  uint32_t bit_flips[64];
+  uint64_t total = 0;
+  memset(bit_flips, 0, sizeof(bit_flips));
+
+  for (uint32_t m = 0; m < MSGS; ++m) {
+    for (size_t i = 0; i < n_bytes; ++i) msg[i] = (uint8_t)SplitMix_next(m*n_bytes + i);
+    uint64_t h0 = hash(msg, n_bytes);
+
+    for (uint32_t f = 0; f < FLIPS; ++f) {
+      size_t bit = f*stride + (7*f) % stride;
+      msg[bit/8] ^= (uint8_t)(1 << (bit & 7));
+      uint64_t diff = h0 ^ hash(msg, n_bytes);
+      msg[bit/8] ^= (uint8_t)(1 << (bit & 7));
+      for (int b = 0; b < 64; ++b) bit_flips[b] += (diff >> b) & 1;
+      total += __builtin_popcountll(diff);
+    }
+  }
+
+  uint32_t lo = bit_flips[0], hi = bit_flips[0];
+  for (int b = 1; b < 64; ++b) {
+    if (bit_flips[b] < lo) lo = bit_flips[b];
+    if (bit_flips[b] > hi) hi = bit_flips[b];
+  }
+
+  printf("%-15s= %.2f %.3f %.3f\n", name, (double)total/(MSGS*FLIPS),
+    (double)lo/(MSGS*FLIPS), (double)hi/(MSGS*FLIPS));
+
+  free(msg);
+}
+
 int main()
 {
   const uint64_t iv[2] = { 972546410955, 972507515111 };
@@ -486,6 +4629,8 @@ int main()
   uint32_t hash32a, hash32b, hash32c, hi, lo;
   uint64_t hash64;
 
+  printf("kernel   = %s\n",AYBern_adlerKernelName());
+
   hash32a = Adler32(un1.s8,sizeof(s1));
   printf("Adler-1  = %08x\n",hash32a);
   hash32b = Adler32(un2.s8,sizeof(s2));
@@ -551,70 +4696,314 @@ int main()
   lo = hash64 & 0xFFFFFFFF;
   printf("C64-3c   = %08x%08x\n",hi,lo);
 
+  // byte API: odd lengths are zero padded, i.e. the same as s1 with its
+  // last 1 or 3 bytes cleared, hashed with the word API
+
+  hash32a = AYBern_adlerHash32Mem(s1,15);
+  printf("32-15B   = %08x\n",hash32a);
+  hash64 = AYBern_adlerHash64Mem(s1,13);
+  hi = hash64 >> 32;
+  lo = hash64 & 0xFFFFFFFF;
+  printf("64-13B   = %08x%08x\n",hi,lo);
+
   #define N (1 << 20)
   uint8_t * big = malloc(N);
   memset(big,1,N);
 
-  hash32a = AYBern_adlerHash32((uint16_t *)big,512);
+  hash32a = AYBern_adlerHash32Mem(big,1024);
   printf("32-1K          = %08x\n",hash32a);
-  hash32a = AYBern_adlerHash32((uint16_t *)big,1024);
+  hash32a = AYBern_adlerHash32Mem(big,2048);
   printf("32-2K          = %08x\n",hash32a);
-  hash32a = AYBern_adlerHash32((uint16_t *)big,N/2);
+  hash32a = AYBern_adlerHash32Mem(big,N);
   printf("32-1M          = %08x\n",hash32a);
 
   big[0] = 0; // change single lo bit
-  hash32a = AYBern_adlerHash32((uint16_t *)big,512);
+  hash32a = AYBern_adlerHash32Mem(big,1024);
   printf("32-1K-lo-bit   = %08x\n",hash32a);
-  hash32a = AYBern_adlerHash32((uint16_t *)big,1024);
+  hash32a = AYBern_adlerHash32Mem(big,2048);
   printf("32-2K-lo-bit   = %08x\n",hash32a);
-  hash32a = AYBern_adlerHash32((uint16_t *)big,N/2);
+  hash32a = AYBern_adlerHash32Mem(big,N);
   printf("32-1M-lo-bit   = %08x\n",hash32a);
 
   big[N-1] = 0; // change single hi bit
-  hash32a = AYBern_adlerHash32((uint16_t *)big,512);
+  hash32a = AYBern_adlerHash32Mem(big,1024);
   printf("32-1K-hi-bit   = %08x\n",hash32a);
-  hash32a = AYBern_adlerHash32((uint16_t *)big,1024);
+  hash32a = AYBern_adlerHash32Mem(big,2048);
   printf("32-2K-hi-bit   = %08x\n",hash32a);
-  hash32a = AYBern_adlerHash32((uint16_t *)big,N/2);
+  hash32a = AYBern_adlerHash32Mem(big,N);
   printf("32-1M-hi-bit   = %08x\n",hash32a);
 
   big[0] = 1; // restore changes
   big[N-1] = 1;
 
-  hash64 = AYBern_adlerHash64((uint32_t *)big,N/8);
+  hash64 = AYBern_adlerHash64Mem(big,N/2);
   hi = hash64 >> 32;
   lo = hash64 & 0xFFFFFFFF;
   printf("64-17          = %08x%08x\n",hi,lo);
 
-  hash64 = AYBern_adlerHash64((uint32_t *)big,N/4);
+  hash64 = AYBern_adlerHash64Mem(big,N);
   hi = hash64 >> 32;
   lo = hash64 & 0xFFFFFFFF;
   printf("64-18          = %08x%08x\n",hi,lo);
 
   big[0] = 0; // change single lo bit
 
-  hash64 = AYBern_adlerHash64((uint32_t *)big,N/8);
+  hash64 = AYBern_adlerHash64Mem(big,N/2);
   hi = hash64 >> 32;
   lo = hash64 & 0xFFFFFFFF;
   printf("64-17-lo-bit   = %08x%08x\n",hi,lo);
 
-  hash64 = AYBern_adlerHash64((uint32_t *)big,N/4);
+  hash64 = AYBern_adlerHash64Mem(big,N);
   hi = hash64 >> 32;
   lo = hash64 & 0xFFFFFFFF;
   printf("64-18-lo-bit   = %08x%08x\n",hi,lo);
 
   big[N-1] = 0; // change single hi-bit
 
-  hash64 = AYBern_adlerHash64((uint32_t *)big,N/8);
+  hash64 = AYBern_adlerHash64Mem(big,N/2);
   hi = hash64 >> 32;
   lo = hash64 & 0xFFFFFFFF;
   printf("64-17-hi-bit   = %08x%08x\n",hi,lo);
 
-  hash64 = AYBern_adlerHash64((uint32_t *)big,N/4);
+  hash64 = AYBern_adlerHash64Mem(big,N);
   hi = hash64 >> 32;
   lo = hash64 & 0xFFFFFFFF;
   printf("64-18-hi-bit   = %08x%08x\n",hi,lo);
 
+  // the wide hash64 formats, and the avalanche quality check against hash64
+
+  hash64 = AYBern_adlerHash64x4(un1.s32,sizeof(s1)/4);
+  printf("64x4-1         = %08x%08x\n",(uint32_t)(hash64 >> 32),(uint32_t)hash64);
+  hash64 = AYBern_adlerHash64x4(un2.s32,sizeof(s2)/4);
+  printf("64x4-2         = %08x%08x\n",(uint32_t)(hash64 >> 32),(uint32_t)hash64);
+  hash64 = AYBern_adlerHash64x4Mem(big,N);
+  printf("64x4-18-hi-bit = %08x%08x\n",(uint32_t)(hash64 >> 32),(uint32_t)hash64);
+  hash64 = AYBern_adlerHash64x8(un1.s32,sizeof(s1)/4);
+  printf("64x8-1         = %08x%08x\n",(uint32_t)(hash64 >> 32),(uint32_t)hash64);
+  hash64 = AYBern_adlerHash64x8(un2.s32,sizeof(s2)/4);
+  printf("64x8-2         = %08x%08x\n",(uint32_t)(hash64 >> 32),(uint32_t)hash64);
+  hash64 = AYBern_adlerHash64x8Mem(big,N);
+  printf("64x8-18-hi-bit = %08x%08x\n",(uint32_t)(hash64 >> 32),(uint32_t)hash64);
+
+  testAvalanche64("64-aval-64B",AYBern_adlerHash64Mem,64);
+  testAvalanche64("64-aval-4K",AYBern_adlerHash64Mem,4096);
+  testAvalanche64("64x4-aval-64B",AYBern_adlerHash64x4Mem,64);
+  testAvalanche64("64x4-aval-4K",AYBern_adlerHash64x4Mem,4096);
+  testAvalanche64("64x8-aval-64B",AYBern_adlerHash64x8Mem,64);
+  testAvalanche64("64x8-aval-4K",AYBern_adlerHash64x8Mem,4096);
+
+  hash64 = AYBern_adlerHashCipherXorshift128_64Mem(big,N,iv,5712234);
+  hi = hash64 >> 32;
+  lo = hash64 & 0xFFFFFFFF;
+  printf("C64-18         = %08x%08x\n",hi,lo);
+
+  // the other keystream generators, on the C64-1c and the C64-18 messages
+
+  hash64 = AYBern_adlerHashCipherXorshift1024_64(un1.s32,sizeof(s1)/4,iv,5712234);
+  printf("X1024-1c       = %08x%08x\n",(uint32_t)(hash64 >> 32),(uint32_t)hash64);
+  hash64 = AYBern_adlerHashCipherXorshift1024_64Mem(big,N,iv,5712234);
+  printf("X1024-18       = %08x%08x\n",(uint32_t)(hash64 >> 32),(uint32_t)hash64);
+  hash64 = AYBern_adlerHashCipherXoshiro256_64(un1.s32,sizeof(s1)/4,iv,5712234);
+  printf("X256-1c        = %08x%08x\n",(uint32_t)(hash64 >> 32),(uint32_t)hash64);
+  hash64 = AYBern_adlerHashCipherXoshiro256_64Mem(big,N,iv,5712234);
+  printf("X256-18        = %08x%08x\n",(uint32_t)(hash64 >> 32),(uint32_t)hash64);
+  hash64 = AYBern_adlerHashCipherChaCha8_64(un1.s32,sizeof(s1)/4,iv,5712234);
+  printf("CC8-1c         = %08x%08x\n",(uint32_t)(hash64 >> 32),(uint32_t)hash64);
+  hash64 = AYBern_adlerHashCipherChaCha8_64Mem(big,N,iv,5712234);
+  printf("CC8-18         = %08x%08x\n",(uint32_t)(hash64 >> 32),(uint32_t)hash64);
+
+  hash64 = AYBern_adlerHashCipherAESCTR_64(un1.s32,sizeof(s1)/4,iv,5712234);
+  printf("AES-1c         = %08x%08x\n",(uint32_t)(hash64 >> 32),(uint32_t)hash64);
+  hash64 = AYBern_adlerHashCipherAESCTR_64Mem(big,N,iv,5712234);
+  printf("AES-18         = %08x%08x\n",(uint32_t)(hash64 >> 32),(uint32_t)hash64);
+
+  hash64 = AYBern_adlerHashCipherV2_64(un1.s32,sizeof(s1)/4,iv,5712234);
+  printf("V2-1c          = %08x%08x\n",(uint32_t)(hash64 >> 32),(uint32_t)hash64);
+  hash64 = AYBern_adlerHashCipherV2_64Mem(big,N,iv,5712234);
+  printf("V2-18          = %08x%08x\n",(uint32_t)(hash64 >> 32),(uint32_t)hash64);
+
+  // encrypt-and-hash: the digest must match C64-1c, and decrypt must verify
+  // it and restore s1
+
+  uint8_t enc[sizeof(s1)], dec[sizeof(s1)];
+  hash64 = AYBern_adlerHashCipherXorshift128_64Encrypt(s1,enc,sizeof(s1),iv,5712234);
+  printf("C64-1c-e       = %08x%08x\n",(uint32_t)(hash64 >> 32),(uint32_t)hash64);
+  int verify = AYBern_adlerHashCipherXorshift128_64Decrypt(enc,dec,sizeof(s1),iv,5712234,hash64);
+  printf("C64-1c-d       = %d %d\n",verify,memcmp(dec,s1,sizeof(s1)) == 0);
+
+  // the native 32-bit cipher variant
+
+  const uint32_t iv32[2] = { 2546410955u, 2507515111u };
+  hash32a = AYBern_adlerHashCipher32(un1.s16,sizeof(s1)/2,iv32,5712234);
+  hash32b = AYBern_adlerHashCipher32(un2.s16,sizeof(s2)/2,iv32,5712234);
+  hash32c = AYBern_adlerHashCipher32(un3.s16,sizeof(s3)/2,iv32,5712234);
+  printf("C32-123c       = %08x %08x %08x\n",hash32a,hash32b,hash32c);
+  hash32a = AYBern_adlerHashCipher32Mem(s1,15,iv32,5712234);
+  printf("C32-15B        = %08x\n",hash32a);
+  hash32a = AYBern_adlerHashCipher32Mem(big,N,iv32,5712234);
+  printf("C32-1M         = %08x\n",hash32a);
+
+  // the zlib compatible Adler-32, and its combine: must match zlib-1M
+
+  hash32a = AYBern_adler32Zlib(1,"Wikipedia",9);
+  hash32b = AYBern_adler32Zlib(1,NULL,0);
+  printf("zlib-Wiki      = %08x %08x\n",hash32a,hash32b);
+  hash32a = AYBern_adler32Zlib(1,big,N);
+  printf("zlib-1M        = %08x\n",hash32a);
+  hash32b = AYBern_adler32Zlib(1,big,333333);
+  hash32c = AYBern_adler32Zlib(1,big + 333333,N - 333333);
+  printf("zlib-combine   = %08x\n",AYBern_adler32ZlibCombine(hash32b,hash32c,N - 333333));
+
+  // multi-digest: must match zlib-1M, 32-1M-hi-bit and 64-18-hi-bit
+
+  AYBern_adlerMultiDigest md;
+  AYBern_adlerMultiDigestMem(big,N,AYBERN_DIGEST_ADLER32 | AYBERN_DIGEST_HASH32 | AYBERN_DIGEST_HASH64,&md);
+  printf("multi-1M       = %08x %08x %08x%08x\n",md.adler32,md.hash32,(uint32_t)(md.hash64 >> 32),(uint32_t)md.hash64);
+  AYBern_adlerMultiDigestMem(big,N,AYBERN_DIGEST_HASH64,&md);
+  printf("multi-1M-64    = %08x %08x %08x%08x\n",md.adler32,md.hash32,(uint32_t)(md.hash64 >> 32),(uint32_t)md.hash64);
+
+  // copy-and-hash: must match 32-1M-hi-bit, 64-18-hi-bit and C64-18, and
+  // copy big, with and without non-temporal stores
+
+  uint8_t * copy = malloc(N);
+  memset(copy,0,N);
+  hash32a = AYBern_adlerHash32Copy(big,copy,N,0);
+  printf("32-1M-copy     = %08x %d\n",hash32a,memcmp(copy,big,N) == 0);
+  memset(copy,0,N);
+  hash64 = AYBern_adlerHash64Copy(big,copy,N,AYBERN_COPY_NONTEMPORAL);
+  printf("64-18-copy-nt  = %08x%08x %d\n",(uint32_t)(hash64 >> 32),(uint32_t)hash64,memcmp(copy,big,N) == 0);
+  memset(copy,0,N);
+  hash64 = AYBern_adlerHashCipherXorshift128_64Copy(big,copy,N,iv,5712234,0);
+  printf("C64-18-copy    = %08x%08x %d\n",(uint32_t)(hash64 >> 32),(uint32_t)hash64,memcmp(copy,big,N) == 0);
+  hash64 = AYBern_adlerHash64Copy(s1,copy,13,0); // must match 64-13B
+  printf("64-13B-copy    = %08x%08x %d\n",(uint32_t)(hash64 >> 32),(uint32_t)hash64,memcmp(copy,s1,13) == 0);
+  free(copy);
+
+  // scatter-gather: big in odd sized segments, which split words and
+  // blocks, and an empty one: must match zlib-1M, 32-1M-hi-bit,
+  // 64-18-hi-bit and C64-18
+
+  const size_t seg[] = { 1, 0, 3, 1022, 524289, 7, N - 1 - 3 - 1022 - 524289 - 7 };
+  struct iovec iov[sizeof(seg)/sizeof(seg[0])];
+  for (size_t v = 0, off = 0; v < sizeof(seg)/sizeof(seg[0]); off += seg[v++]) {
+    iov[v].iov_base = (seg[v]) ? big + off : NULL;
+    iov[v].iov_len = seg[v];
+  }
+  hash32a = AYBern_adler32Zlibv(1,iov,sizeof(seg)/sizeof(seg[0]));
+  hash32b = AYBern_adlerHash32v(iov,sizeof(seg)/sizeof(seg[0]));
+  printf("iov-1M         = %08x %08x\n",hash32a,hash32b);
+  hash64 = AYBern_adlerHash64v(iov,sizeof(seg)/sizeof(seg[0]));
+  printf("iov-64-18      = %08x%08x\n",(uint32_t)(hash64 >> 32),(uint32_t)hash64);
+  hash64 = AYBern_adlerHashCipherXorshift128_64v(iov,sizeof(seg)/sizeof(seg[0]),iv,5712234);
+  printf("iov-C64-18     = %08x%08x\n",(uint32_t)(hash64 >> 32),(uint32_t)hash64);
+
+  AYBern_CipherKey * key = AYBern_cipherKeyCreate(iv,5712234,N); // must match the Mem func
+
+  hash64 = AYBern_adlerHashCipherXorshift128_64Keyed(key,s1,sizeof(s1));
+  hi = hash64 >> 32;
+  lo = hash64 & 0xFFFFFFFF;
+  printf("C64-1c-k       = %08x%08x\n",hi,lo);
+
+  hash64 = AYBern_adlerHashCipherXorshift128_64Keyed(key,big,N);
+  hi = hash64 >> 32;
+  lo = hash64 & 0xFFFFFFFF;
+  printf("C64-18-k       = %08x%08x\n",hi,lo);
+
+  AYBern_cipherKeyDestroy(key);
+
+  AYBern_ThreadPool * pool = AYBern_threadPoolCreate(4); // must match the serial funcs
+
+  hash32a = AYBern_adlerHash32Parallel(pool,(uint16_t *)big,N/2);
+  printf("32-1M-hi-bit-p = %08x\n",hash32a);
+
+  hash64 = AYBern_adlerHash64Parallel(pool,(uint32_t *)big,N/4);
+  hi = hash64 >> 32;
+  lo = hash64 & 0xFFFFFFFF;
+  printf("64-18-hi-bit-p = %08x%08x\n",hi,lo);
+
+  hash64 = AYBern_adlerHashCipherXorshift128_64Parallel(pool,(uint32_t *)big,N/4,iv,5712234);
+  hi = hash64 >> 32;
+  lo = hash64 & 0xFFFFFFFF;
+  printf("C64-18-p       = %08x%08x\n",hi,lo);
+
+  // strided 2D, with big as a 1024 x 1024 byte frame: the full width must
+  // match 32-1M-hi-bit and 64-18-hi-bit, a 1000 byte wide region must match
+  // its gathered copy, and every tile of the grids must match its strided
+  // hash, with whole word tiles (the fast path) and odd ones
+
+  hash32a = AYBern_adlerHash32Strided(big,1024,1024,1024);
+  hash64 = AYBern_adlerHash64Strided(big,1024,1024,1024);
+  printf("2D-full        = %08x %08x%08x\n",hash32a,(uint32_t)(hash64 >> 32),(uint32_t)hash64);
+
+  uint8_t * gather = malloc(1000*1024);
+  for (uint32_t r = 0; r < 1024; ++r) memcpy(gather + 1000*r,big + 1024*r + 3,1000);
+  hash32a = AYBern_adlerHash32Strided(big + 3,1000,1024,1024);
+  hash64 = AYBern_adlerHash64Strided(big + 3,1000,1024,1024);
+  printf("2D-1000        = %08x %08x%08x %d %d\n",hash32a,(uint32_t)(hash64 >> 32),(uint32_t)hash64,
+    hash32a == AYBern_adlerHash32Mem(gather,1000*1024),hash64 == AYBern_adlerHash64Mem(gather,1000*1024));
+  free(gather);
+
+  uint64_t grid[11*11];
+  const uint32_t tile_w[2] = { 256, 99 }, tile_h[2] = { 64, 100 };
+  for (uint32_t g = 0; g < 2; ++g) {
+    uint32_t tx = (1000 + tile_w[g] - 1) / tile_w[g], ty = (1024 + tile_h[g] - 1) / tile_h[g], bad = 0;
+    int ret = AYBern_adlerHash64TileGrid(pool,big,1000,1024,1024,tile_w[g],tile_h[g],grid);
+    for (uint32_t y = 0; y < ty; ++y) {
+      for (uint32_t x = 0; x < tx; ++x) {
+        uint32_t w = (1000 - x*tile_w[g] < tile_w[g]) ? 1000 - x*tile_w[g] : tile_w[g];
+        uint32_t h = (1024 - y*tile_h[g] < tile_h[g]) ? 1024 - y*tile_h[g] : tile_h[g];
+        bad += grid[y*tx + x] != AYBern_adlerHash64Strided(big + 1024*y*tile_h[g] + x*tile_w[g],w,1024,h);
+      }
+    }
+    hash64 = grid[tx*ty - 1];
+    printf("2D-grid-%u      = %d %u %u %08x%08x\n",g,ret,tx*ty,bad,(uint32_t)(hash64 >> 32),(uint32_t)hash64);
+  }
+
+  AYBern_threadPoolDestroy(pool);
+
+  AYBern_adlerHash32Ctx ctx32; // streaming: must match the one-shot funcs
+  AYBern_adlerHash64Ctx ctx64;
+  AYBern_adlerHash32Init(&ctx32);
+  AYBern_adlerHash64Init(&ctx64);
+  AYBern_adlerHash32Update(&ctx32,NULL,0); // an empty update may pass NULL
+  AYBern_adlerHash64Update(&ctx64,NULL,0);
+  for (uint32_t off = 0; off < N; off += 999) {
+    uint32_t chunk = (N - off < 999) ? N - off : 999;
+    AYBern_adlerHash32Update(&ctx32,big + off,chunk);
+    AYBern_adlerHash64Update(&ctx64,big + off,chunk);
+  }
+
+  hash32a = AYBern_adlerHash32Final(&ctx32);
+  printf("32-1M-hi-bit-s = %08x\n",hash32a);
+
+  hash64 = AYBern_adlerHash64Final(&ctx64);
+  hi = hash64 >> 32;
+  lo = hash64 & 0xFFFFFFFF;
+  printf("64-18-hi-bit-s = %08x%08x\n",hi,lo);
+
+  // batch: must match the one-at-a-time funcs, 32-1, 32-2, 32-3, 32-15B and
+  // (the long key) 32-1M-hi-bit
+
+  const void * keys[5] = { s1, s2, s3, s1, big };
+  size_t key_bytes[5] = { sizeof(s1), sizeof(s2), sizeof(s3), 15, N };
+  uint32_t batch[5];
+  AYBern_adlerHash32Batch(keys,key_bytes,batch,5);
+  printf("32-batch       = %08x %08x %08x %08x %08x\n",batch[0],batch[1],batch[2],batch[3],batch[4]);
+
+  // cipher batch: must match C64-1a, C64-2b, C64-3c, C64-18 and (the empty
+  // message) 0, with every message under its own seed
+
+  const void * msgs[5] = { s1, s2, s3, big, s1 };
+  size_t msg_bytes[5] = { sizeof(s1), sizeof(s2), sizeof(s3), N, 0 };
+  const uint64_t ivs[5][2] = { { iv[0], iv[1] }, { iv[0], iv[1] }, { iv[0], iv[1] }, { iv[0], iv[1] }, { iv[0], iv[1] } };
+  const uint64_t seeds[5] = { 0, 1, 5712234, 5712234, 0 };
+  uint64_t cbatch[5];
+  AYBern_adlerHashCipherXorshift128_64Batch(msgs,msg_bytes,ivs,seeds,cbatch,5);
+  for (int b = 0; b < 5; ++b) {
+    printf("%s%08x%08x",b ? " " : "C64-batch      = ",(uint32_t)(cbatch[b] >> 32),(uint32_t)cbatch[b]);
+  }
+  printf("\n");
+
   return 0;
 }
 
@@ -641,6 +5030,8 @@ C64-3b   = ba50c55214f80258
 C64-1c   = f375ee63a2c5eb86
 C64-2c   = e243b03d4580a193
 C64-3c   = 1877b8c138803a6b
+32-15B   = 40f60047
+64-13B   = db16ffddbb0a67d8
 32-1K          = 90a4e01c
 32-2K          = 79bf9e62
 32-1M          = bb13620f
@@ -656,7 +5047,467 @@ C64-3c   = 1877b8c138803a6b
 64-18-lo-bit   = b3a9c1b57ffda7a4
 64-17-hi-bit   = e821b63d929e2ee6
 64-18-hi-bit   = 9e96c74a0888ad27
+64x4-1         = e768d9fab584d055
+64x4-2         = b5b39a353d834c92
+64x4-18-hi-bit = b211061a7471c536
+64x8-1         = e768d9fab584d055
+64x8-2         = b5b39a353d834c92
+64x8-18-hi-bit = 7f5fbe97fc734cea
+64-aval-64B    = 32.09 0.483 0.515
+64-aval-4K     = 31.98 0.484 0.513
+64x4-aval-64B  = 31.92 0.482 0.516
+64x4-aval-4K   = 32.05 0.491 0.515
+64x8-aval-64B  = 31.96 0.487 0.514
+64x8-aval-4K   = 32.07 0.486 0.517
+C64-18         = 71dd11ab09cb6c54
+X1024-1c       = edfa1fc6fa65929e
+X1024-18       = e4e54f85484935e9
+X256-1c        = 7fd170d773a63b1f
+X256-18        = b1dfe0dcc556b464
+CC8-1c         = fe9cbd25da22df24
+CC8-18         = b856cb9398b939d6
+AES-1c         = 8cba00b1a30413ae
+AES-18         = 36e0739c47c86977
+V2-1c          = a00ed91bfb14fadb
+V2-18          = 8d978618952d17d0
+C64-1c-e       = f375ee63a2c5eb86
+C64-1c-d       = 0 1
+C32-123c       = 76b16ed9 58bbc242 16b8adba
+C32-15B        = a20777cb
+C32-1M         = f56a5696
+zlib-Wiki      = 11e60398 00000001
+zlib-1M        = 70f700ef
+zlib-combine   = 70f700ef
+multi-1M       = 70f700ef 1f4759ad 9e96c74a0888ad27
+multi-1M-64    = 00000000 00000000 9e96c74a0888ad27
+32-1M-copy     = 1f4759ad 1
+64-18-copy-nt  = 9e96c74a0888ad27 1
+C64-18-copy    = 71dd11ab09cb6c54 1
+64-13B-copy    = db16ffddbb0a67d8 1
+iov-1M         = 70f700ef 1f4759ad
+iov-64-18      = 9e96c74a0888ad27
+iov-C64-18     = 71dd11ab09cb6c54
+C64-1c-k       = f375ee63a2c5eb86
+C64-18-k       = 71dd11ab09cb6c54
+32-1M-hi-bit-p = 1f4759ad
+64-18-hi-bit-p = 9e96c74a0888ad27
+C64-18-p       = 71dd11ab09cb6c54
+2D-full        = 1f4759ad 9e96c74a0888ad27
+2D-1000        = 1da59354 eb854d5fdfdd1a96 1 1
+2D-grid-0      = 0 64 0 44ada43eab995607
+2D-grid-1      = 0 121 0 8a776a5207a52321
+32-1M-hi-bit-s = 1f4759ad
+64-18-hi-bit-s = 9e96c74a0888ad27
+32-batch       = 5f02470c 025feb85 5f4f201c 40f60047 1f4759ad
+C64-batch      = ca605f1595260c0b 7a878617dc5b42d1 1877b8c138803a6b 71dd11ab09cb6c54 0000000000000000
 
 #endif // 0: test vector output
 
 #endif // TEST
+
+#ifdef BENCH
+
+/*
+  Throughput benchmark: $ make BENCH=1 && ./ayb-adler-bench [options]
+
+  Sweeps the message size from 8 bytes to 1 GiB by factors of 8 for every
+  hash, including the toy Adler32() baseline, which is run in 8K chunks
+  because that is its limit. Every (hash, size) pair gets one untimed warmup
+  rep, which also faults in the buffer, and then -r timed reps, each of which
+  hashes at least 64 MiB in total. We report the best and the median rep, GB/s
+  of the best rep, and TSC cycles/byte (reference cycles, which differ from
+  core cycles when the CPU is not running at its nominal frequency). The
+  process is pinned to one CPU so that the TSC and the caches stay put.
+
+  JSON goes to stdout, a human readable table to stderr, i.e.
+  $ ./ayb-adler-bench > bench.json
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sched.h>
+
+#ifdef AYBERN_X86
+#include <x86intrin.h>
+#define BENCH_TSC() __rdtsc()
+#else
+#define BENCH_TSC() UINT64_C(0)
+#endif
+
+// stop the compiler from hoisting a pure hash call with unchanged args out of
+// the timing loop
+#define BENCH_OPAQUE(p) __asm__ volatile("" : "+r"(p))
+
+static const uint64_t bench_iv[2] = { 972546410955, 972507515111 };
+
+static uint64_t benchAdler32(const uint8_t * msg, size_t n_bytes)
+{
+  uint64_t sum = 0;
+  for (size_t k = 0; k < n_bytes; k += 8192) {
+    sum += Adler32(msg + k, (n_bytes - k < 8192) ? (uint32_t)(n_bytes - k) : 8192);
+  }
+  return sum;
+}
+
+static uint64_t benchAdler32Zlib(const uint8_t * msg, size_t n_bytes)
+{
+  return AYBern_adler32Zlib(1, msg, n_bytes);
+}
+
+static uint64_t benchMultiAdler32Hash64(const uint8_t * msg, size_t n_bytes)
+{
+  AYBern_adlerMultiDigest md;
+  AYBern_adlerMultiDigestMem(msg, n_bytes, AYBERN_DIGEST_ADLER32 | AYBERN_DIGEST_HASH64, &md);
+  return md.adler32 ^ md.hash64;
+}
+
+static uint64_t benchMultiAll(const uint8_t * msg, size_t n_bytes)
+{
+  AYBern_adlerMultiDigest md;
+  AYBern_adlerMultiDigestMem(msg, n_bytes, AYBERN_DIGEST_ADLER32 | AYBERN_DIGEST_HASH32 | AYBERN_DIGEST_HASH64, &md);
+  return md.adler32 ^ md.hash32 ^ md.hash64;
+}
+
+static uint64_t benchHash32(const uint8_t * msg, size_t n_bytes)
+{
+  return AYBern_adlerHash32Mem(msg, n_bytes);
+}
+
+static uint64_t benchHash64(const uint8_t * msg, size_t n_bytes)
+{
+  return AYBern_adlerHash64Mem(msg, n_bytes);
+}
+
+static uint64_t benchHash64x4(const uint8_t * msg, size_t n_bytes)
+{
+  return AYBern_adlerHash64x4Mem(msg, n_bytes);
+}
+
+static uint64_t benchHash64x8(const uint8_t * msg, size_t n_bytes)
+{
+  return AYBern_adlerHash64x8Mem(msg, n_bytes);
+}
+
+static uint64_t benchCipher64(const uint8_t * msg, size_t n_bytes)
+{
+  return AYBern_adlerHashCipherXorshift128_64Mem(msg, n_bytes, bench_iv, 5712234);
+}
+
+// the keystream is cached for up to BENCH_KEY_BYTES, larger messages measure
+// the uncached path of the keyed hash
+#define BENCH_KEY_BYTES ((size_t)64 << 20)
+
+static AYBern_CipherKey * bench_key;
+
+static uint64_t benchCipher32(const uint8_t * msg, size_t n_bytes)
+{
+  static const uint32_t iv32[2] = { 2546410955u, 2507515111u };
+  return AYBern_adlerHashCipher32Mem(msg, n_bytes, iv32, 5712234);
+}
+
+static uint64_t benchCipher64Xorshift1024(const uint8_t * msg, size_t n_bytes)
+{
+  return AYBern_adlerHashCipherXorshift1024_64Mem(msg, n_bytes, bench_iv, 5712234);
+}
+
+static uint64_t benchCipher64Xoshiro256(const uint8_t * msg, size_t n_bytes)
+{
+  return AYBern_adlerHashCipherXoshiro256_64Mem(msg, n_bytes, bench_iv, 5712234);
+}
+
+static uint64_t benchCipher64ChaCha8(const uint8_t * msg, size_t n_bytes)
+{
+  return AYBern_adlerHashCipherChaCha8_64Mem(msg, n_bytes, bench_iv, 5712234);
+}
+
+static uint64_t benchCipher64AESCTR(const uint8_t * msg, size_t n_bytes)
+{
+  return AYBern_adlerHashCipherAESCTR_64Mem(msg, n_bytes, bench_iv, 5712234);
+}
+
+static uint64_t benchCipher64V2(const uint8_t * msg, size_t n_bytes)
+{
+  return AYBern_adlerHashCipherV2_64Mem(msg, n_bytes, bench_iv, 5712234);
+}
+
+// the encrypted or copied message goes to bench_out, which is as large as
+// the buffer, and 64-byte aligned for the non-temporal stores
+
+static uint8_t * bench_out;
+
+static uint64_t benchCipher64Encrypt(const uint8_t * msg, size_t n_bytes)
+{
+  return AYBern_adlerHashCipherXorshift128_64Encrypt(msg, bench_out, n_bytes, bench_iv, 5712234);
+}
+
+static uint64_t benchHash64Copy(const uint8_t * msg, size_t n_bytes)
+{
+  return AYBern_adlerHash64Copy(msg, bench_out, n_bytes, 0);
+}
+
+static uint64_t benchHash64CopyNT(const uint8_t * msg, size_t n_bytes)
+{
+  return AYBern_adlerHash64Copy(msg, bench_out, n_bytes, AYBERN_COPY_NONTEMPORAL);
+}
+
+// the baseline of the copy-and-hash: a memcpy() and then a hash of the copy
+
+static uint64_t benchHash64MemcpyHash(const uint8_t * msg, size_t n_bytes)
+{
+  memcpy(bench_out, msg, n_bytes);
+  return AYBern_adlerHash64Mem(bench_out, n_bytes);
+}
+
+// the message in BENCH_IOV_SEGS segments with odd boundaries, so that
+// words are split between segments: compare with hash64
+
+#define BENCH_IOV_SEGS 64
+
+static uint64_t benchHash64v(const uint8_t * msg, size_t n_bytes)
+{
+  struct iovec iov[BENCH_IOV_SEGS];
+  size_t off = 0;
+
+  for (size_t v = 0; v < BENCH_IOV_SEGS; ++v) {
+    size_t end = (v == BENCH_IOV_SEGS - 1) ? n_bytes : ((v + 1) * (n_bytes / BENCH_IOV_SEGS)) | 1;
+    if (end > n_bytes) end = n_bytes;
+    iov[v].iov_base = (void *)(msg + off);
+    iov[v].iov_len = end - off;
+    off = end;
+  }
+
+  return AYBern_adlerHash64v(iov, BENCH_IOV_SEGS);
+}
+
+// the message as a frame of BENCH_FRAME_ROW byte rows, e.g. 1024 RGBA
+// pixels, in 64 x 64 pixel tiles, serially: compare with hash64
+
+#define BENCH_FRAME_ROW 4096
+#define BENCH_TILE_BYTES 256
+#define BENCH_TILE_ROWS 64
+
+static uint64_t * bench_tiles; // 1 digest per BENCH_TILE_BYTES * BENCH_TILE_ROWS bytes, and a partial row
+
+static uint64_t benchHash64TileGrid(const uint8_t * msg, size_t n_bytes)
+{
+  size_t rows = n_bytes / BENCH_FRAME_ROW;
+
+  if (!rows) return AYBern_adlerHash64Strided(msg, n_bytes, n_bytes, 1);
+
+  AYBern_adlerHash64TileGrid(NULL, msg, BENCH_FRAME_ROW, rows, BENCH_FRAME_ROW,
+    BENCH_TILE_BYTES, BENCH_TILE_ROWS, bench_tiles);
+  return bench_tiles[0];
+}
+
+static uint64_t benchCipher64Keyed(const uint8_t * msg, size_t n_bytes)
+{
+  return AYBern_adlerHashCipherXorshift128_64Keyed(bench_key, msg, n_bytes);
+}
+
+// the message is split into CIPHER_LANES messages, each under its own seed
+
+static uint64_t benchCipher64Batch(const uint8_t * msg, size_t n_bytes)
+{
+  const void * msgs[CIPHER_LANES];
+  size_t n[CIPHER_LANES];
+  uint64_t ivs[CIPHER_LANES][2], seeds[CIPHER_LANES], hash_codes[CIPHER_LANES];
+  size_t part = n_bytes / CIPHER_LANES;
+
+  for (uint32_t l = 0; l < CIPHER_LANES; ++l) {
+    msgs[l] = msg + l * part;
+    n[l] = (l == CIPHER_LANES - 1) ? n_bytes - l * part : part;
+    ivs[l][0] = bench_iv[0];
+    ivs[l][1] = bench_iv[1];
+    seeds[l] = 5712234 + l;
+  }
+
+  AYBern_adlerHashCipherXorshift128_64Batch(msgs, n, (const uint64_t (*)[2])ivs, seeds, hash_codes, CIPHER_LANES);
+
+  uint64_t h = 0;
+  for (uint32_t l = 0; l < CIPHER_LANES; ++l) h ^= hash_codes[l];
+  return h;
+}
+
+typedef struct {
+  const char * name;
+  uint64_t (*fn)(const uint8_t * msg, size_t n_bytes);
+} BenchAlgo;
+
+static const BenchAlgo bench_algos[] = {
+  { "adler32", benchAdler32 },
+  { "adler32-zlib", benchAdler32Zlib },
+  { "hash32", benchHash32 },
+  { "hash64", benchHash64 },
+  { "multi-a32+64", benchMultiAdler32Hash64 },
+  { "multi-all", benchMultiAll },
+  { "hash64x4", benchHash64x4 },
+  { "hash64x8", benchHash64x8 },
+  { "hash64-copy", benchHash64Copy },
+  { "hash64-copy-nt", benchHash64CopyNT },
+  { "hash64-memcpy", benchHash64MemcpyHash },
+  { "hash64-iov", benchHash64v },
+  { "hash64-tiles", benchHash64TileGrid },
+  { "cipher64", benchCipher64 },
+  { "cipher32", benchCipher32 },
+  { "cipher64-x1024", benchCipher64Xorshift1024 },
+  { "cipher64-x256", benchCipher64Xoshiro256 },
+  { "cipher64-chacha8", benchCipher64ChaCha8 },
+  { "cipher64-aes", benchCipher64AESCTR },
+  { "cipher64-v2", benchCipher64V2 },
+  { "cipher64-enc", benchCipher64Encrypt },
+  { "cipher64-key", benchCipher64Keyed },
+  { "cipher64-batch", benchCipher64Batch },
+};
+
+#define N_BENCH_ALGOS (sizeof(bench_algos)/sizeof(bench_algos[0]))
+
+static double benchNow(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int benchCmp(const void * a, const void * b)
+{
+  double x = *(const double *)a, y = *(const double *)b;
+  return (x > y) - (x < y);
+}
+
+static void benchUsage(const char * argv0)
+{
+  fprintf(stderr,
+    "usage: %s [-c cpu] [-r reps] [-s min_bytes] [-m max_bytes] [-k kernel] [-a algo]\n"
+    "  defaults: -c <current cpu> -r 5 -s 8 -m 1073741824, all kernels' best, all algos\n",
+    argv0);
+}
+
+int main(int argc, char * argv[])
+{
+  int cpu = sched_getcpu();
+  unsigned reps = 5;
+  size_t min_bytes = 8;
+  size_t max_bytes = (size_t)1 << 30;
+  const char * only_algo = NULL;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "c:r:s:m:k:a:h")) != -1) {
+    switch (opt) {
+    case 'c': cpu = atoi(optarg); break;
+    case 'r': reps = (unsigned)atoi(optarg); break;
+    case 's': min_bytes = (size_t)strtoull(optarg, NULL, 0); break;
+    case 'm': max_bytes = (size_t)strtoull(optarg, NULL, 0); break;
+    case 'k':
+      if (AYBern_adlerSelectKernel(optarg) != 0) {
+        fprintf(stderr, "kernel %s: unknown or not supported by this CPU\n", optarg);
+        return 1;
+      }
+      break;
+    case 'a': only_algo = optarg; break;
+    default: benchUsage(argv[0]); return opt == 'h' ? 0 : 1;
+    }
+  }
+
+  if (reps < 1) reps = 1;
+  if (min_bytes < 1) min_bytes = 1;
+
+  cpu_set_t cpus;
+  CPU_ZERO(&cpus);
+  CPU_SET(cpu, &cpus);
+  if (sched_setaffinity(0, sizeof(cpus), &cpus) != 0) {
+    fprintf(stderr, "warning: cannot pin to cpu %d\n", cpu);
+    cpu = -1;
+  }
+
+  uint8_t * buf = NULL;
+  while (max_bytes >= min_bytes && !(buf = malloc(max_bytes))) max_bytes >>= 1;
+  if (!buf) {
+    fprintf(stderr, "out of memory\n");
+    return 1;
+  }
+  for (size_t k = 0; k < max_bytes; ++k) buf[k] = (uint8_t)(k * 2654435761u >> 24);
+
+  uint8_t * bench_out_mem = malloc(max_bytes + 64);
+  bench_out = (bench_out_mem) ? bench_out_mem + (-(uintptr_t)bench_out_mem & 63) : NULL;
+  bench_tiles = malloc((max_bytes / (BENCH_TILE_BYTES * BENCH_TILE_ROWS) + BENCH_FRAME_ROW / BENCH_TILE_BYTES) * sizeof(uint64_t));
+  bench_key = AYBern_cipherKeyCreate(bench_iv, 5712234, (max_bytes < BENCH_KEY_BYTES) ? max_bytes : BENCH_KEY_BYTES);
+
+  double * ns = malloc(reps * sizeof(double));
+  uint64_t * tsc = malloc(reps * sizeof(uint64_t));
+  if (!bench_out || !bench_tiles || !bench_key || !ns || !tsc) {
+    fprintf(stderr, "out of memory\n");
+    return 1;
+  }
+
+  const size_t min_rep_bytes = (size_t)64 << 20;
+  volatile uint64_t sink = 0; // so that the hashes are not dead code
+  int first = 1;
+
+  printf("{\n  \"kernel\": \"%s\",\n  \"cpu\": %d,\n  \"reps\": %u,\n  \"tsc\": %s,\n  \"results\": [\n",
+    AYBern_adlerKernelName(), cpu, reps, BENCH_TSC() ? "true" : "false");
+  fprintf(stderr, "kernel %s, cpu %d, %u reps\n", AYBern_adlerKernelName(), cpu, reps);
+  fprintf(stderr, "%-16s %12s %10s %12s %12s %9s %9s\n",
+    "algo", "bytes", "iters", "best_ns", "median_ns", "GB/s", "cyc/B");
+
+  for (const BenchAlgo * algo = bench_algos; algo < bench_algos + N_BENCH_ALGOS; ++algo) {
+    if (only_algo && strcmp(only_algo, algo->name) != 0) continue;
+
+    for (size_t n_bytes = min_bytes; n_bytes <= max_bytes; n_bytes *= 8) { // size loop: begin
+      size_t iters = (n_bytes < min_rep_bytes) ? min_rep_bytes / n_bytes : 1;
+
+      for (unsigned r = 0; r <= reps; ++r) { // rep 0 is the warmup
+        const uint8_t * msg = buf;
+        uint64_t h = 0;
+        uint64_t t0 = BENCH_TSC();
+        double start = benchNow();
+        for (size_t i = 0; i < iters; ++i) {
+          BENCH_OPAQUE(msg);
+          h ^= algo->fn(msg, n_bytes);
+        }
+        double stop = benchNow();
+        uint64_t t1 = BENCH_TSC();
+        sink ^= h;
+        if (r) {
+          ns[r-1] = (stop - start) * 1e9;
+          tsc[r-1] = t1 - t0;
+        }
+      }
+
+      // the TSC count of the fastest rep
+      unsigned best = 0;
+      for (unsigned r = 1; r < reps; ++r) if (ns[r] < ns[best]) best = r;
+      double best_ns = ns[best];
+      double best_tsc = (double)tsc[best];
+      qsort(ns, reps, sizeof(double), benchCmp);
+      double median_ns = (reps & 1) ? ns[reps/2] : (ns[reps/2 - 1] + ns[reps/2]) / 2;
+
+      double total = (double)n_bytes * iters;
+      double gbps = total / best_ns;
+      double cpb = best_tsc / total;
+
+      printf("%s    { \"algo\": \"%s\", \"bytes\": %zu, \"iters\": %zu, \"best_ns\": %.0f, "
+        "\"median_ns\": %.0f, \"gbps\": %.3f, \"cycles_per_byte\": %.4f }",
+        first ? "" : ",\n", algo->name, n_bytes, iters, best_ns, median_ns, gbps, cpb);
+      fprintf(stderr, "%-16s %12zu %10zu %12.0f %12.0f %9.3f %9.4f\n",
+        algo->name, n_bytes, iters, best_ns, median_ns, gbps, cpb);
+      first = 0;
+
+      if (n_bytes > max_bytes / 8) break; // no wrap around
+    } // size loop: end
+  }
+
+  printf("\n  ]\n}\n");
+
+  AYBern_cipherKeyDestroy(bench_key);
+  free(bench_out_mem);
+  free(bench_tiles);
+  free(tsc);
+  free(ns);
+  free(buf);
+
+  return 0;
+}
+
+#endif // BENCH
@@ -23,6 +23,9 @@ REVISIONS:
 2017-05-22: 1.0.0: AB: new
 */
 
+#ifndef AYB_ADLER_H
+#define AYB_ADLER_H
+
 GCC_ATTRIB(nothrow,nonnull,pure)
 uint32_t AYBern_adlerHash32(const uint16_t * msg, uint32_t n);
 
@@ -32,3 +35,401 @@ uint64_t AYBern_adlerHash64(const uint32_t * msg, uint32_t n);
 GCC_ATTRIB(nothrow,nonnull,pure)
 uint64_t AYBern_adlerHashCipherXorshift128_64(const uint32_t * msg, uint32_t n,
     const uint64_t iv[2], uint64_t seed);
+
+// The legacy, zlib compatible, Adler-32 (RFC 1950), and its combine, for
+// verifying old checksums: the same API and results as zlib's adler32()
+// and adler32_combine(). Start with adler = 1, or get it with msg = NULL.
+// Combine() returns the Adler-32 of the concatenation of 2 messages, given
+// their Adler-32's and the length of the 2nd one.
+
+GCC_ATTRIB(nothrow,pure)
+uint32_t AYBern_adler32Zlib(uint32_t adler, const void * msg, size_t n_bytes);
+
+GCC_ATTRIB(nothrow,const)
+uint32_t AYBern_adler32ZlibCombine(uint32_t adler1, uint32_t adler2, uint64_t len2);
+
+// The wide hash64 formats: 4 or 8 interleaved word lanes, each summed like a
+// hash64 block, and folded into the hash64 block chain at the end of every
+// 4 or 8 x 512K byte block. Faster than AYBern_adlerHash64() on large
+// messages, with the same bit spread per lane, but their own digests. The
+// Mem funcs follow the byte rules of AYBern_adlerHash64Mem().
+
+GCC_ATTRIB(nothrow,nonnull,pure)
+uint64_t AYBern_adlerHash64x4(const uint32_t * msg, uint32_t n);
+
+GCC_ATTRIB(nothrow,nonnull,pure)
+uint64_t AYBern_adlerHash64x4Mem(const void * msg, size_t n_bytes);
+
+GCC_ATTRIB(nothrow,nonnull,pure)
+uint64_t AYBern_adlerHash64x8(const uint32_t * msg, uint32_t n);
+
+GCC_ATTRIB(nothrow,nonnull,pure)
+uint64_t AYBern_adlerHash64x8Mem(const void * msg, size_t n_bytes);
+
+// The native 32-bit cipher variant, for 32-bit targets: the 16-bit words
+// and the block structure of AYBern_adlerHash32(), with a Xoroshiro64**
+// keystream and 32-bit arithmetic only in the loop.
+
+GCC_ATTRIB(nothrow,nonnull,pure)
+uint32_t AYBern_adlerHashCipher32(const uint16_t * msg, uint32_t n,
+    const uint32_t iv[2], uint32_t seed);
+
+// Byte-granular entry points: msg needs no alignment and n_bytes need not be
+// a multiple of the word size. There is no length limit other than size_t:
+// the uint32_t word count of the word funcs caps them at 8G/16G bytes, but
+// the block counter is 64 bits, so a single digest can cover e.g. a whole
+// mmap'd device. The words are loaded in native byte order,
+// i.e. as if the byte buffer had been cast to uint16_t/uint32_t, and a
+// message which does not end on a word boundary is padded with zero bytes.
+// E.g. AYBern_adlerHash64Mem(buf, 4*n) == AYBern_adlerHash64((const uint32_t *)buf, n)
+
+GCC_ATTRIB(nothrow,nonnull(1),pure)
+uint32_t AYBern_adlerHash32Mem(const void * msg, size_t n_bytes);
+
+GCC_ATTRIB(nothrow,nonnull(1),pure)
+uint64_t AYBern_adlerHash64Mem(const void * msg, size_t n_bytes);
+
+GCC_ATTRIB(nothrow,nonnull(1,3),pure)
+uint64_t AYBern_adlerHashCipherXorshift128_64Mem(const void * msg, size_t n_bytes,
+    const uint64_t iv[2], uint64_t seed);
+
+GCC_ATTRIB(nothrow,nonnull(1,3),pure)
+uint32_t AYBern_adlerHashCipher32Mem(const void * msg, size_t n_bytes,
+    const uint32_t iv[2], uint32_t seed);
+
+// The cipher variant with other keystream generators, for longer messages
+// or more strength than Xoroshiro128+ provides, at a higher cost per byte:
+// xorshift1024* (16 words of state), xoshiro256** (4 words of state) and
+// ChaCha8 (a cryptographic stream cipher, 256-bit key). They share the block
+// structure and the iv/seed tempering of the original, and the byte rules
+// of the Mem funcs above, but every generator has its own digests.
+
+GCC_ATTRIB(nothrow,nonnull,pure)
+uint64_t AYBern_adlerHashCipherXorshift1024_64(const uint32_t * msg, uint32_t n,
+    const uint64_t iv[2], uint64_t seed);
+
+GCC_ATTRIB(nothrow,nonnull(1,3),pure)
+uint64_t AYBern_adlerHashCipherXorshift1024_64Mem(const void * msg, size_t n_bytes,
+    const uint64_t iv[2], uint64_t seed);
+
+GCC_ATTRIB(nothrow,nonnull,pure)
+uint64_t AYBern_adlerHashCipherXoshiro256_64(const uint32_t * msg, uint32_t n,
+    const uint64_t iv[2], uint64_t seed);
+
+GCC_ATTRIB(nothrow,nonnull(1,3),pure)
+uint64_t AYBern_adlerHashCipherXoshiro256_64Mem(const void * msg, size_t n_bytes,
+    const uint64_t iv[2], uint64_t seed);
+
+GCC_ATTRIB(nothrow,nonnull,pure)
+uint64_t AYBern_adlerHashCipherChaCha8_64(const uint32_t * msg, uint32_t n,
+    const uint64_t iv[2], uint64_t seed);
+
+GCC_ATTRIB(nothrow,nonnull(1,3),pure)
+uint64_t AYBern_adlerHashCipherChaCha8_64Mem(const void * msg, size_t n_bytes,
+    const uint64_t iv[2], uint64_t seed);
+
+// AES-128 counter mode keystream, with the same block structure. The key
+// and the nonce are tempered from iv and seed. The AES-NI path is selected
+// at run time, apart from the kernel level, with a software AES fallback for
+// CPUs without AES-NI and for the "scalar" kernel, and the "avx512vaes"
+// kernel uses 512-bit AES (see AYBern_adlerSelectKernel() below). They all
+// give the same digests.
+
+GCC_ATTRIB(nothrow,nonnull,pure)
+uint64_t AYBern_adlerHashCipherAESCTR_64(const uint32_t * msg, uint32_t n,
+    const uint64_t iv[2], uint64_t seed);
+
+GCC_ATTRIB(nothrow,nonnull(1,3),pure)
+uint64_t AYBern_adlerHashCipherAESCTR_64Mem(const void * msg, size_t n_bytes,
+    const uint64_t iv[2], uint64_t seed);
+
+// Cipher format v2, designed for SIMD: 8 independent Xoroshiro128+ lanes,
+// all tempered from iv and seed, mask interleaved 64-byte strides of the
+// message, so that the keystream is generated 8 lanes at a time, and one
+// core keeps up with memory bandwidth. Same block structure and byte rules
+// as the original variant, but its own digests.
+
+GCC_ATTRIB(nothrow,nonnull,pure)
+uint64_t AYBern_adlerHashCipherV2_64(const uint32_t * msg, uint32_t n,
+    const uint64_t iv[2], uint64_t seed);
+
+GCC_ATTRIB(nothrow,nonnull(1,3),pure)
+uint64_t AYBern_adlerHashCipherV2_64Mem(const void * msg, size_t n_bytes,
+    const uint64_t iv[2], uint64_t seed);
+
+// Encrypt-and-hash in a single pass: Encrypt() writes the encrypted message
+// to out and returns AYBern_adlerHashCipherXorshift128_64Mem(msg, n_bytes,
+// iv, seed). Decrypt() is its inverse: it writes the decrypted message to
+// out and returns 0 if its digest is hash_code, or -1 if it is not, in which
+// case out must be discarded. The encryption keystream is independent of the
+// hash keystream, but derived from the same (iv, seed). out may be msg, and
+// exactly n_bytes are written.
+
+GCC_ATTRIB(nothrow,nonnull(1,2,4))
+uint64_t AYBern_adlerHashCipherXorshift128_64Encrypt(const void * msg, void * out, size_t n_bytes,
+    const uint64_t iv[2], uint64_t seed);
+
+GCC_ATTRIB(nothrow,nonnull(1,2,4))
+int AYBern_adlerHashCipherXorshift128_64Decrypt(const void * msg, void * out, size_t n_bytes,
+    const uint64_t iv[2], uint64_t seed, uint64_t hash_code);
+
+// Keyed cipher hashing: a key schedule for hashing many messages under the
+// same (iv, seed). AYBern_cipherKeyCreate() tempers iv and seed once and, if
+// max_bytes != 0, precomputes the keystream of the first max_bytes of a
+// message (at a cost of max_bytes of memory), so that the hash of a message
+// which fits is a plain XOR-and-weighted-sum. Longer messages are hashed too,
+// from the tempered state. AYBern_adlerHashCipherXorshift128_64Keyed(key, ...)
+// == AYBern_adlerHashCipherXorshift128_64Mem(..., iv, seed).
+// AYBern_cipherKeyCreate() returns NULL on failure. A key is read-only once
+// created, so threads may share it.
+
+typedef struct AYBern_CipherKey AYBern_CipherKey;
+
+GCC_ATTRIB(nothrow,nonnull(1))
+AYBern_CipherKey * AYBern_cipherKeyCreate(const uint64_t iv[2], uint64_t seed, size_t max_bytes);
+
+GCC_ATTRIB(nothrow)
+void AYBern_cipherKeyDestroy(AYBern_CipherKey * key);
+
+GCC_ATTRIB(nothrow,nonnull,pure)
+uint64_t AYBern_adlerHashCipherXorshift128_64Keyed(const AYBern_CipherKey * key, const void * msg, size_t n_bytes);
+
+// Batch: hash_codes[i] = AYBern_adlerHash32Mem(keys[i], n_bytes[i]) for
+// i < count. Meant for many short keys (<= 1K bytes), whose chain steps are
+// computed 16 at a time in SIMD lanes. Longer keys are fine, just not faster.
+
+GCC_ATTRIB(nothrow,nonnull)
+void AYBern_adlerHash32Batch(const void * const * keys, const size_t * n_bytes,
+    uint32_t * hash_codes, size_t count);
+
+// Cipher batch: hash_codes[i] = AYBern_adlerHashCipherXorshift128_64Mem(msgs[i],
+// n_bytes[i], ivs[i], seeds[i]) for i < count. Every message has its own key,
+// e.g. MAC verification of packets from many peers. The messages' PRNGs are
+// run side by side in SIMD lanes, so it pays from 2 messages upwards, and
+// messages of different lengths are fine.
+
+GCC_ATTRIB(nothrow,nonnull)
+void AYBern_adlerHashCipherXorshift128_64Batch(const void * const * msgs, const size_t * n_bytes,
+    const uint64_t (*ivs)[2], const uint64_t * seeds, uint64_t * hash_codes, size_t count);
+
+// Streaming: Init(), any number of Update() calls with chunks of any size,
+// then Final() returns exactly the one-shot result for the concatenation of
+// the chunks, with the same byte rules as the Mem funcs above.
+// Final() does not modify the context, so it may be used for intermediate
+// digests. The context fields are private.
+
+typedef struct {
+  uint32_t hash_code;
+  uint32_t adler_sum; // of the current block so far
+  uint64_t j; // blocks chained so far
+  uint32_t pos; // words in the current block so far
+  uint32_t tail_len;
+  uint8_t tail[2]; // a word split between 2 Update() calls
+} AYBern_adlerHash32Ctx;
+
+typedef struct {
+  uint64_t hash_code;
+  uint64_t adler_sum;
+  uint64_t j;
+  uint32_t pos;
+  uint32_t tail_len;
+  uint8_t tail[4];
+} AYBern_adlerHash64Ctx;
+
+typedef struct {
+  uint64_t hash_code;
+  uint64_t adler_sum;
+  uint64_t s[2]; // PRNG state
+  uint64_t j;
+  uint32_t r32_odd; // PRNG mask of the next word when pos is odd
+  uint32_t pos;
+  uint32_t tail_len;
+  uint8_t tail[4];
+} AYBern_adlerHashCipherXorshift128_64Ctx;
+
+GCC_ATTRIB(nothrow,nonnull)
+void AYBern_adlerHash32Init(AYBern_adlerHash32Ctx * ctx);
+
+GCC_ATTRIB(nothrow,nonnull(1))
+void AYBern_adlerHash32Update(AYBern_adlerHash32Ctx * ctx, const void * data, size_t n_bytes);
+
+GCC_ATTRIB(nothrow,nonnull,pure)
+uint32_t AYBern_adlerHash32Final(const AYBern_adlerHash32Ctx * ctx);
+
+GCC_ATTRIB(nothrow,nonnull)
+void AYBern_adlerHash64Init(AYBern_adlerHash64Ctx * ctx);
+
+GCC_ATTRIB(nothrow,nonnull(1))
+void AYBern_adlerHash64Update(AYBern_adlerHash64Ctx * ctx, const void * data, size_t n_bytes);
+
+GCC_ATTRIB(nothrow,nonnull,pure)
+uint64_t AYBern_adlerHash64Final(const AYBern_adlerHash64Ctx * ctx);
+
+GCC_ATTRIB(nothrow,nonnull)
+void AYBern_adlerHashCipherXorshift128_64Init(AYBern_adlerHashCipherXorshift128_64Ctx * ctx,
+    const uint64_t iv[2], uint64_t seed);
+
+GCC_ATTRIB(nothrow,nonnull(1))
+void AYBern_adlerHashCipherXorshift128_64Update(AYBern_adlerHashCipherXorshift128_64Ctx * ctx,
+    const void * data, size_t n_bytes);
+
+GCC_ATTRIB(nothrow,nonnull,pure)
+uint64_t AYBern_adlerHashCipherXorshift128_64Final(const AYBern_adlerHashCipherXorshift128_64Ctx * ctx);
+
+// Copy-and-hash: copy n_bytes from msg to out, which must not overlap, and
+// return the digest of the respective Mem func, in a single pass over the
+// message. With AYBERN_COPY_NONTEMPORAL in flags the copy bypasses the
+// cache, if out is 64-byte aligned, for a destination that will not be read
+// soon.
+
+enum {
+  AYBERN_COPY_NONTEMPORAL = 1
+};
+
+GCC_ATTRIB(nothrow,nonnull)
+uint32_t AYBern_adlerHash32Copy(const void * msg, void * out, size_t n_bytes, unsigned flags);
+
+GCC_ATTRIB(nothrow,nonnull)
+uint64_t AYBern_adlerHash64Copy(const void * msg, void * out, size_t n_bytes, unsigned flags);
+
+GCC_ATTRIB(nothrow,nonnull)
+uint64_t AYBern_adlerHashCipherXorshift128_64Copy(const void * msg, void * out, size_t n_bytes,
+    const uint64_t iv[2], uint64_t seed, unsigned flags);
+
+// Multi-digest: any of the legacy Adler-32 (AYBern_adler32Zlib()), hash32
+// and hash64 of the same message, in a single pass over memory, for
+// migrations which need both the old and the new digest of every object.
+// The which parameter of AYBern_adlerMultiInit() and
+// AYBern_adlerMultiDigestMem() is an OR of the AYBERN_DIGEST_ flags; the
+// digests not requested are 0. The results are those of
+// AYBern_adler32Zlib(1, ...), AYBern_adlerHash32Mem() and
+// AYBern_adlerHash64Mem(), and the contexts follow the streaming rules above.
+
+enum {
+  AYBERN_DIGEST_ADLER32 = 1,
+  AYBERN_DIGEST_HASH32 = 2,
+  AYBERN_DIGEST_HASH64 = 4
+};
+
+typedef struct {
+  uint32_t adler32;
+  uint32_t hash32;
+  uint64_t hash64;
+} AYBern_adlerMultiDigest;
+
+typedef struct {
+  unsigned which;
+  uint32_t adler32;
+  AYBern_adlerHash32Ctx h32;
+  AYBern_adlerHash64Ctx h64;
+} AYBern_adlerMultiCtx;
+
+GCC_ATTRIB(nothrow,nonnull)
+void AYBern_adlerMultiInit(AYBern_adlerMultiCtx * ctx, unsigned which);
+
+GCC_ATTRIB(nothrow,nonnull(1))
+void AYBern_adlerMultiUpdate(AYBern_adlerMultiCtx * ctx, const void * data, size_t n_bytes);
+
+GCC_ATTRIB(nothrow,nonnull)
+void AYBern_adlerMultiFinal(const AYBern_adlerMultiCtx * ctx, AYBern_adlerMultiDigest * digest);
+
+GCC_ATTRIB(nothrow,nonnull)
+void AYBern_adlerMultiDigestMem(const void * msg, size_t n_bytes, unsigned which,
+    AYBern_adlerMultiDigest * digest);
+
+// Scatter-gather ("hashv"): the digest of the concatenation of iovcnt
+// segments, as in readv()/writev(), without copying them into one buffer.
+// The results are exactly those of the Mem funcs, and AYBern_adler32Zlib(),
+// on the flattened message, whatever the segment boundaries. Empty segments
+// may have a NULL iov_base.
+
+struct iovec;
+
+GCC_ATTRIB(nothrow,nonnull(2),pure)
+uint32_t AYBern_adler32Zlibv(uint32_t adler, const struct iovec * iov, size_t iovcnt);
+
+GCC_ATTRIB(nothrow,nonnull,pure)
+uint32_t AYBern_adlerHash32v(const struct iovec * iov, size_t iovcnt);
+
+GCC_ATTRIB(nothrow,nonnull,pure)
+uint64_t AYBern_adlerHash64v(const struct iovec * iov, size_t iovcnt);
+
+GCC_ATTRIB(nothrow,nonnull,pure)
+uint64_t AYBern_adlerHashCipherXorshift128_64v(const struct iovec * iov, size_t iovcnt,
+    const uint64_t iv[2], uint64_t seed);
+
+// Runtime CPU dispatch: the best kernels that the CPU supports are selected
+// once at load time. AYBern_adlerKernelName() reports the selection: "scalar",
+// "sse4.1", "avx2", "avx512", "avx512ifma" or "avx512vaes". AYBern_adlerSelectKernel()
+// overrides it, e.g. for testing or benchmarking, and returns 0 on success or
+// -1 if the name is unknown or not supported by the CPU. It is not thread
+// safe, so call it before any hashing starts.
+
+GCC_ATTRIB(nothrow,pure)
+const char * AYBern_adlerKernelName(void);
+
+GCC_ATTRIB(nothrow,nonnull)
+int AYBern_adlerSelectKernel(const char * name);
+
+// Block-parallel hashing: the per-block sums are computed by a persistent
+// thread pool and chained in block order, so the result is bit-identical to
+// the serial function. n_threads is the total number of threads that work on
+// a hash, including the caller; 0 means one per online CPU.
+// AYBern_threadPoolCreate() returns NULL on failure. A NULL pool, or a
+// message too short to be worth splitting, falls back to the serial function.
+// The Mem variants follow the byte rules of the Mem funcs above.
+
+typedef struct AYBern_ThreadPool AYBern_ThreadPool;
+
+GCC_ATTRIB(nothrow)
+AYBern_ThreadPool * AYBern_threadPoolCreate(unsigned n_threads);
+
+GCC_ATTRIB(nothrow)
+void AYBern_threadPoolDestroy(AYBern_ThreadPool * pool);
+
+GCC_ATTRIB(nothrow,nonnull,pure)
+unsigned AYBern_threadPoolSize(const AYBern_ThreadPool * pool);
+
+GCC_ATTRIB(nothrow,nonnull(2))
+uint32_t AYBern_adlerHash32MemParallel(AYBern_ThreadPool * pool, const void * msg, size_t n_bytes);
+
+GCC_ATTRIB(nothrow,nonnull(2))
+uint64_t AYBern_adlerHash64MemParallel(AYBern_ThreadPool * pool, const void * msg, size_t n_bytes);
+
+GCC_ATTRIB(nothrow,nonnull(2))
+uint32_t AYBern_adlerHash32Parallel(AYBern_ThreadPool * pool, const uint16_t * msg, uint32_t n);
+
+GCC_ATTRIB(nothrow,nonnull(2))
+uint64_t AYBern_adlerHash64Parallel(AYBern_ThreadPool * pool, const uint32_t * msg, uint32_t n);
+
+GCC_ATTRIB(nothrow,nonnull(2,4))
+uint64_t AYBern_adlerHashCipherXorshift128_64MemParallel(AYBern_ThreadPool * pool, const void * msg, size_t n_bytes,
+    const uint64_t iv[2], uint64_t seed);
+
+GCC_ATTRIB(nothrow,nonnull(2,4))
+uint64_t AYBern_adlerHashCipherXorshift128_64Parallel(AYBern_ThreadPool * pool, const uint32_t * msg, uint32_t n,
+    const uint64_t iv[2], uint64_t seed);
+
+// Strided 2D: the digest of rows rows of row_bytes each, which start stride
+// bytes apart, e.g. an image tile or a matrix sub-block, without gathering
+// them: exactly the Mem func of the gathered rows.
+//
+// TileGrid: the hash64 of every tile_bytes x tile_rows tile of a frame of
+// height rows of width_bytes, in 1 pass over the frame, into digests[]
+// (tiles_x * tiles_y, row major, where tiles_x = ceil(width_bytes /
+// tile_bytes) and tiles_y = ceil(height / tile_rows)). The edge tiles are
+// partial, and each digest is AYBern_adlerHash64Strided() of its tile. The
+// bands of tile rows run in parallel in pool, or serially if it is NULL.
+// Returns 0, or -1 for a bad geometry or out of memory.
+
+GCC_ATTRIB(nothrow,nonnull,pure)
+uint32_t AYBern_adlerHash32Strided(const void * base, size_t row_bytes, size_t stride, size_t rows);
+
+GCC_ATTRIB(nothrow,nonnull,pure)
+uint64_t AYBern_adlerHash64Strided(const void * base, size_t row_bytes, size_t stride, size_t rows);
+
+GCC_ATTRIB(nothrow,nonnull(2,8))
+int AYBern_adlerHash64TileGrid(AYBern_ThreadPool * pool, const void * base, size_t width_bytes, size_t height,
+    size_t stride, size_t tile_bytes, size_t tile_rows, uint64_t * digests);
+
+#endif // AYB_ADLER_H